@@ -0,0 +1,120 @@
+#include "CatalogGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "core/Errors.h"
+
+namespace ps
+{
+    // Распределения <random> на разных стандартных библиотеках дают разные
+    // последовательности; сам mt19937_64 определён стандартом, поэтому числа
+    // берутся из него напрямую.
+    class PlanRandom final
+    {
+    public:
+        explicit PlanRandom(std::uint64_t seed) : m_engine(seed) {}
+
+        std::uint32_t Below(std::uint32_t n) { return static_cast<std::uint32_t>(m_engine() % n); }
+        bool Chance(double p) { return static_cast<double>(m_engine() >> 11) * 0x1.0p-53 < p; }
+
+    private:
+        std::mt19937_64 m_engine;
+    };
+
+    static std::string MakeName(ComponentType type, std::uint32_t number, std::size_t nameLen)
+    {
+        const char* prefix = type == ComponentType::Product ? "Изделие-" : type == ComponentType::Node ? "Узел-" : "Деталь-";
+
+        std::string digits = std::to_string(number);
+        digits.insert(0, digits.size() < 7 ? 7 - digits.size() : 0, '0');
+
+        std::string name = prefix + digits;
+        if (name.size() < nameLen) name.append(nameLen - name.size(), '.');
+        return name;
+    }
+
+    std::uint32_t CatalogPlan::RootOf(std::uint32_t index) const
+    {
+        while (components[index].parent != UINT32_MAX) index = components[index].parent;
+        return index;
+    }
+
+    CatalogPlan GenerateCatalog(const GeneratorOptions& options)
+    {
+        if (options.depth < 2) throw ValidationException("Глубина каталога — не меньше 2 уровней (изделия и детали).");
+        if (options.components < options.depth) throw ValidationException("Компонентов меньше, чем уровней.");
+        if (options.fanout == 0) throw ValidationException("Число связей в спецификации должно быть положительным.");
+        if (options.sharing < 0 || options.sharing > 1) throw ValidationException("Доля общих связей — от 0 до 1.");
+
+        // размеры уровней растут в fanout раз сверху вниз
+        std::vector<double> weights(options.depth);
+        double total = 0;
+        for (std::uint32_t k = 0; k < options.depth; k++) total += weights[k] = std::pow(static_cast<double>(options.fanout), k);
+
+        std::vector<std::uint32_t> sizes(options.depth);
+        std::uint32_t assigned = 0;
+        for (std::uint32_t k = 0; k + 1 < options.depth; k++)
+        {
+            sizes[k] = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(options.components * weights[k] / total));
+            assigned += sizes[k];
+        }
+        sizes.back() = options.components > assigned ? options.components - assigned : 1;
+
+        CatalogPlan plan;
+        std::vector<std::uint32_t> levelStart(options.depth + 1);
+        for (std::uint32_t k = 0; k < options.depth; k++)
+        {
+            levelStart[k] = static_cast<std::uint32_t>(plan.components.size());
+            const auto type = k == 0 ? ComponentType::Product : k + 1 == options.depth ? ComponentType::Detail : ComponentType::Node;
+            for (std::uint32_t i = 0; i < sizes[k]; i++)
+            {
+                CatalogPlan::Component c;
+                c.type = type;
+                c.level = k;
+                c.name = MakeName(type, static_cast<std::uint32_t>(plan.components.size()) + 1, options.nameLen);
+                plan.components.push_back(std::move(c));
+            }
+        }
+        levelStart[options.depth] = static_cast<std::uint32_t>(plan.components.size());
+
+        std::size_t maxLen = 0;
+        for (const auto& c : plan.components) maxLen = std::max(maxLen, c.name.size());
+        plan.maxNameLen = static_cast<std::uint16_t>(maxLen);
+
+        // Связи уровня k ведут на уровень k + 1: по кругу на следующий ещё не
+        // взятый компонент или, с вероятностью sharing, на случайный (общий).
+        PlanRandom random(options.seed);
+        std::vector<std::uint32_t> picked;
+        for (std::uint32_t k = 0; k + 1 < options.depth; k++)
+        {
+            const auto lower = levelStart[k + 1];
+            const auto lowerCount = levelStart[k + 2] - lower;
+            std::uint32_t cursor = 0;
+
+            for (auto owner = levelStart[k]; owner < levelStart[k + 1]; owner++)
+            {
+                picked.clear();
+                for (std::uint32_t j = 0; j < options.fanout && j < lowerCount; j++)
+                {
+                    std::uint32_t part;
+                    if (random.Chance(options.sharing))
+                    {
+                        part = lower + random.Below(lowerCount);
+                    }
+                    else
+                    {
+                        part = lower + cursor;
+                        cursor = (cursor + 1) % lowerCount;
+                    }
+                    if (std::find(picked.begin(), picked.end(), part) != picked.end()) continue;
+                    picked.push_back(part);
+
+                    if (plan.components[part].parent == UINT32_MAX) plan.components[part].parent = owner;
+                    plan.links.push_back({ owner, part, static_cast<std::uint16_t>(1 + random.Below(9)) });
+                }
+            }
+        }
+
+        return plan;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "domain/Models.h"
+
+namespace ps
+{
+    // Параметры синтетического каталога. Один и тот же набор параметров (и seed)
+    // всегда даёт один и тот же каталог — на любой платформе.
+    struct GeneratorOptions
+    {
+        std::uint32_t components = 2000;
+        std::uint32_t depth = 4;    // уровней: изделия, узлы (depth - 2 уровня), детали
+        std::uint32_t fanout = 5;   // связей в спецификации каждого изделия и узла
+        double sharing = 0.2;       // доля связей на случайный компонент уровня ниже (общие узлы и детали)
+        std::uint32_t nameLen = 24; // байт в имени (UTF-8); короче номера с префиксом не бывает
+        std::uint64_t seed = 1;
+    };
+
+    // План каталога: компоненты по уровням сверху вниз и связи между ними.
+    // Связи идут только на уровень ниже, поэтому циклов в плане нет.
+    struct CatalogPlan
+    {
+        struct Component
+        {
+            std::string name;
+            ComponentType type = ComponentType::Detail;
+            std::uint32_t level = 0;
+            std::uint32_t parent = UINT32_MAX; // первый владелец (для поиска предков)
+        };
+
+        struct Link
+        {
+            std::uint32_t owner = 0;
+            std::uint32_t part = 0;
+            std::uint16_t qty = 1;
+        };
+
+        std::uint16_t maxNameLen = 0;
+        std::vector<Component> components;
+        std::vector<Link> links;
+
+        // изделие, из которого компонент index достижим (через первых владельцев)
+        std::uint32_t RootOf(std::uint32_t index) const;
+    };
+
+    CatalogPlan GenerateCatalog(const GeneratorOptions& options);
+}
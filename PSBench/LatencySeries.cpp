@@ -0,0 +1,76 @@
+#include "LatencySeries.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace ps
+{
+    LatencySeries::LatencySeries(std::string name) : m_name(std::move(name)) {}
+
+    const std::string& LatencySeries::Name() const { return m_name; }
+    std::size_t LatencySeries::Count() const { return m_samples.size(); }
+
+    double LatencySeries::TotalMs() const
+    {
+        return static_cast<double>(std::accumulate(m_samples.begin(), m_samples.end(), std::uint64_t{ 0 })) / 1e6;
+    }
+
+    double LatencySeries::OpsPerSecond() const
+    {
+        const auto ms = TotalMs();
+        return ms > 0 ? static_cast<double>(Count()) * 1000.0 / ms : 0.0;
+    }
+
+    double LatencySeries::PercentileUs(double p) const
+    {
+        if (m_samples.empty()) return 0.0;
+        if (!m_sorted)
+        {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+
+        const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * static_cast<double>(m_samples.size())));
+        const auto index = std::min(m_samples.size() - 1, rank == 0 ? 0 : rank - 1);
+        return static_cast<double>(m_samples[index]) / 1e3;
+    }
+
+    // printf выравнивает по байтам, а заголовки по-русски: ширина считается в символах
+    static void AppendCell(std::string& out, const std::string& text, std::size_t width, bool left)
+    {
+        const auto chars = static_cast<std::size_t>(std::count_if(text.begin(), text.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+        const std::string pad(chars < width ? width - chars : 0, ' ');
+        out += left ? text + pad : pad + text;
+        out += ' ';
+    }
+
+    static std::string Fixed(double value, int digits)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*f", digits, value);
+        return buf;
+    }
+
+    std::string FormatReport(const std::vector<LatencySeries>& series)
+    {
+        std::string out;
+        AppendCell(out, "операция", 28, true);
+        for (const char* title : { "вызовов", "всего, мс", "оп/с", "p50, мкс", "p90, мкс", "p99, мкс", "max, мкс" })
+            AppendCell(out, title, 11, false);
+        out.back() = '\n';
+
+        for (const auto& s : series)
+        {
+            if (s.Count() == 0) continue;
+
+            AppendCell(out, s.Name(), 28, true);
+            AppendCell(out, std::to_string(s.Count()), 11, false);
+            AppendCell(out, Fixed(s.TotalMs(), 1), 11, false);
+            AppendCell(out, Fixed(s.OpsPerSecond(), 0), 11, false);
+            for (const double p : { 50.0, 90.0, 99.0, 100.0 }) AppendCell(out, Fixed(s.PercentileUs(p), 1), 11, false);
+            out.back() = '\n';
+        }
+        return out;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ps
+{
+    // Время каждого вызова одной операции и сводка по ним: пропускная способность
+    // и процентили задержки.
+    class LatencySeries final
+    {
+    public:
+        explicit LatencySeries(std::string name);
+
+        template<typename Fn>
+        void Measure(Fn&& fn)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const auto stop = std::chrono::steady_clock::now();
+            m_samples.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+            m_sorted = false;
+        }
+
+        const std::string& Name() const;
+        std::size_t Count() const;
+        double TotalMs() const;
+        double OpsPerSecond() const;
+        // p — от 0 до 100 (ближайший ранг); 0 для пустой серии
+        double PercentileUs(double p) const;
+
+    private:
+        std::string m_name;
+        mutable std::vector<std::uint64_t> m_samples; // нс
+        mutable bool m_sorted = true;
+    };
+
+    // таблица по сериям: число вызовов, время, оп/с, p50/p90/p99/max в мкс
+    std::string FormatReport(const std::vector<LatencySeries>& series);
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "core/ConsoleUtf8.h"
+#include "core/Errors.h"
+#include "core/OperationStats.h"
+#include "core/UtfConv.h"
+#include "services/CatalogService.h"
+#include "services/CommandRegistry.h"
+#include "services/CommandStats.h"
+#include "services/CommandTrace.h"
+#include "services/Commands.h"
+
+using namespace ps;
+
+// Воспроизведение записи команд (ps_console --trace) теми же обработчиками,
+// что и в консоли. Файлы каталога берутся по путям из записи относительно
+// текущего каталога, вывод команд отбрасывается. Время Execute и обращения
+// к файлам каждой команды учитываются так же, как в консоли для Stats
+// (CommandStats), поэтому сводки сравнимы.
+
+struct ReplayOptions
+{
+    std::string tracePath;
+    bool paced = false;
+    bool help = false;
+};
+
+static const char* UsageText =
+    "ps_replay файл [параметры]\n"
+    "  --paced   выдерживать промежутки между командами, как при записи\n"
+    "            (по умолчанию команды идут подряд без пауз)\n";
+
+static ReplayOptions ParseArgs(int argc, char** argv)
+{
+    ReplayOptions opts;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string key = argv[i];
+        if (key == "--help" || key == "-h") opts.help = true;
+        else if (key == "--paced") opts.paced = true;
+        else if (!key.empty() && key[0] != '-' && opts.tracePath.empty()) opts.tracePath = key;
+        else throw ValidationException("Неизвестный параметр " + key + ". Список параметров: --help.");
+    }
+    if (!opts.help && opts.tracePath.empty()) throw ValidationException("Не указан файл записи команд.");
+    return opts;
+}
+
+static void Write(const std::string& utf8) { ConsoleWriteW(Utf8ToWide(utf8)); }
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        ps::ConfigureConsoleForCyrillic();
+
+        const auto opts = ParseArgs(argc, argv);
+        if (opts.help)
+        {
+            Write(UsageText);
+            return 0;
+        }
+
+        const auto trace = ReadCommandTrace(opts.tracePath);
+
+        CatalogService service;
+        CommandRegistry registry;
+        for (auto& cmd : CreateDefaultCommands())
+            registry.Register(std::move(cmd));
+
+        // своя сводка: записанный Stats reset её не сбрасывает
+        CommandStats stats;
+        std::size_t executed = 0;
+        std::size_t failed = 0;
+        std::size_t unknown = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& entry : trace)
+        {
+            auto* handler = registry.Find(entry.command.name);
+            if (!handler)
+            {
+                unknown++;
+                continue;
+            }
+
+            if (opts.paced) std::this_thread::sleep_until(start + std::chrono::microseconds(entry.offsetUs));
+
+            const auto countersBefore = ReadOperationCounters();
+            const auto started = std::chrono::steady_clock::now();
+            const auto res = handler->Execute(entry.command, service);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+            stats.Record(handler->Name(), static_cast<std::uint64_t>(elapsed.count()), ReadOperationCounters() - countersBefore);
+            executed++;
+            if (!res.error.empty()) failed++;
+            if (res.shouldExit) break;
+        }
+        const auto wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Write("Записано команд: " + std::to_string(trace.size()) + ", выполнено: " + std::to_string(executed) +
+              ", с ошибкой: " + std::to_string(failed) + ", неизвестных: " + std::to_string(unknown) +
+              "; время воспроизведения " + std::to_string(static_cast<std::uint64_t>(wallMs)) + " мс" +
+              (opts.paced ? " (с паузами записи)" : "") + "\n\n");
+        Write(FormatCommandStats(stats.Entries()));
+    }
+    catch (const PsException& ex)
+    {
+        ps::ConsoleWriteErrW(L"Ошибка: ");
+        ps::ConsoleWriteErrW(Utf8ToWide(ex.what()));
+        ps::ConsoleWriteErrW(L"\n");
+        return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        ps::ConsoleWriteErrW(L"Критическая ошибка: ");
+        ps::ConsoleWriteErrW(Utf8ToWide(ex.what()));
+        ps::ConsoleWriteErrW(L"\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/ConsoleUtf8.h"
+#include "core/Errors.h"
+#include "core/UtfConv.h"
+#include "infra/ProductFile.h"
+#include "services/CatalogService.h"
+
+#include "CatalogGenerator.h"
+#include "LatencySeries.h"
+
+using namespace ps;
+
+// Замеры ps_core на синтетическом каталоге. Каталог строится по плану
+// GenerateCatalog через CatalogService; время каждого вызова попадает в серию,
+// по серии печатаются оп/с и процентили задержки.
+//
+// WouldCreateCycle закрыт в CatalogService, поэтому меряется через InputSpecItem,
+// который проверка отклоняет: узел нижнего уровня получает в спецификацию своё же
+// изделие, и обход идёт от изделия вниз через весь его состав.
+
+struct BenchOptions
+{
+    GeneratorOptions catalog;
+    StorageBackend backend = DefaultStorageBackend;
+    std::string baseName = "ps_bench";
+    std::size_t samples = 1000; // вызовов поиска, проверок цикла и PrintSpecTree
+    std::size_t repeat = 3;     // вызовов ListSpecificationRoots и Truncate
+    bool keepFiles = false;
+    bool help = false;
+};
+
+static const char* UsageText =
+    "ps_bench [параметры]\n"
+    "  --components N   компонентов в каталоге (2000)\n"
+    "  --depth D        уровней: изделия, узлы, детали (4)\n"
+    "  --fanout F       связей в спецификации изделия или узла (5)\n"
+    "  --sharing P      доля связей на общие компоненты, 0..1 (0.2)\n"
+    "  --name-len L     байт в имени компонента (24)\n"
+    "  --seed S         начальное значение генератора (1)\n"
+    "  --backend B      fstream | posix | memory (posix)\n"
+    "  --base NAME      имя файлов каталога без расширения (ps_bench)\n"
+    "  --samples K      вызовов поиска, проверки цикла и PrintSpecTree (1000)\n"
+    "  --repeat R       вызовов ListSpecificationRoots и Truncate (3)\n"
+    "  --keep           не удалять файлы каталога после замеров\n";
+
+static std::uint64_t ParseNumber(const std::string& key, const std::string& value)
+{
+    char* end = nullptr;
+    const auto n = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') throw ValidationException("Параметр " + key + " ожидает целое число.");
+    return n;
+}
+
+static StorageBackend ParseBackend(const std::string& value)
+{
+    for (const auto b : { StorageBackend::Fstream, StorageBackend::Posix, StorageBackend::Memory })
+        if (ToString(b) == value) return b;
+    throw ValidationException("Неизвестное хранилище: " + value + ".");
+}
+
+static BenchOptions ParseArgs(int argc, char** argv)
+{
+    BenchOptions opts;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string key = argv[i];
+        if (key == "--help" || key == "-h")
+        {
+            opts.help = true;
+            continue;
+        }
+        if (key == "--keep")
+        {
+            opts.keepFiles = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) throw ValidationException("Для параметра " + key + " не указано значение.");
+        const std::string value = argv[++i];
+
+        if (key == "--components") opts.catalog.components = static_cast<std::uint32_t>(ParseNumber(key, value));
+        else if (key == "--depth") opts.catalog.depth = static_cast<std::uint32_t>(ParseNumber(key, value));
+        else if (key == "--fanout") opts.catalog.fanout = static_cast<std::uint32_t>(ParseNumber(key, value));
+        else if (key == "--sharing") opts.catalog.sharing = std::strtod(value.c_str(), nullptr);
+        else if (key == "--name-len") opts.catalog.nameLen = static_cast<std::uint32_t>(ParseNumber(key, value));
+        else if (key == "--seed") opts.catalog.seed = ParseNumber(key, value);
+        else if (key == "--backend") opts.backend = ParseBackend(value);
+        else if (key == "--base") opts.baseName = value;
+        else if (key == "--samples") opts.samples = static_cast<std::size_t>(ParseNumber(key, value));
+        else if (key == "--repeat") opts.repeat = static_cast<std::size_t>(ParseNumber(key, value));
+        else throw ValidationException("Неизвестный параметр " + key + ". Список параметров: --help.");
+    }
+    return opts;
+}
+
+static void Write(const std::string& utf8) { ConsoleWriteW(Utf8ToWide(utf8)); }
+
+static void RemoveCatalogFiles(const BenchOptions& opts)
+{
+    const auto prd = opts.baseName + ".prd";
+    std::vector<std::string> paths = { prd, opts.baseName + ".prs" };
+    for (auto& p : ProductFile::SidecarPathsFor(prd)) paths.push_back(std::move(p));
+
+    // отсутствующий файл ошибкой не считается
+    for (const auto& p : paths) RemoveStorageFile(opts.backend, p);
+}
+
+static std::vector<LatencySeries> RunBenchmarks(const BenchOptions& opts, const CatalogPlan& plan)
+{
+    LatencySeries input("InputComponent");
+    LatencySeries link("InputSpecItem");
+    LatencySeries findHit("FindActiveByName (есть)");
+    LatencySeries findMiss("FindActiveByName (нет)");
+    LatencySeries cycle("WouldCreateCycle");
+    LatencySeries print("PrintSpecTree");
+    LatencySeries roots("ListSpecificationRoots");
+    LatencySeries truncate("Truncate");
+
+    std::mt19937_64 random(opts.catalog.seed);
+    auto pick = [&](std::size_t n) { return static_cast<std::size_t>(random() % n); };
+
+    CatalogService service;
+    service.Create(opts.baseName, plan.maxNameLen, std::nullopt, opts.backend);
+
+    for (const auto& c : plan.components)
+        input.Measure([&] { service.InputComponent(c.name, c.type); });
+
+    for (const auto& l : plan.links)
+    {
+        const auto& owner = plan.components[l.owner].name;
+        const auto& part = plan.components[l.part].name;
+        link.Measure([&] { service.InputSpecItem(owner, part, l.qty); });
+    }
+    service.Close();
+
+    // поиск по имени — на уровне файла компонентов, без сервиса
+    {
+        ProductFile products;
+        products.Open(opts.baseName + ".prd", opts.backend);
+        for (std::size_t i = 0; i < opts.samples; i++)
+        {
+            const auto& name = plan.components[pick(plan.components.size())].name;
+            findHit.Measure([&] { products.FindActiveByName(name); });
+
+            const auto missing = name + "~";
+            findMiss.Measure([&] { products.FindActiveByName(missing); });
+        }
+        products.Close();
+    }
+
+    service.Open(opts.baseName, opts.backend);
+
+    std::vector<std::uint32_t> deepNodes;
+    std::vector<std::uint32_t> products;
+    for (std::uint32_t i = 0; i < plan.components.size(); i++)
+    {
+        const auto& c = plan.components[i];
+        if (c.type == ComponentType::Product) products.push_back(i);
+        if (c.type == ComponentType::Node && c.level + 2 == opts.catalog.depth && c.parent != UINT32_MAX) deepNodes.push_back(i);
+    }
+
+    for (std::size_t i = 0; i < opts.samples && !deepNodes.empty(); i++)
+    {
+        const auto owner = deepNodes[pick(deepNodes.size())];
+        const auto& ownerName = plan.components[owner].name;
+        const auto& rootName = plan.components[plan.RootOf(owner)].name;
+
+        bool rejected = false;
+        cycle.Measure([&]
+        {
+            try
+            {
+                service.InputSpecItem(ownerName, rootName, 1);
+            }
+            catch (const ValidationException&)
+            {
+                rejected = true;
+            }
+        });
+        if (!rejected) throw ValidationException("Связь " + ownerName + " -> " + rootName + " не отклонена проверкой цикла.");
+    }
+
+    for (std::size_t i = 0; i < opts.samples; i++)
+    {
+        const auto& name = plan.components[products[pick(products.size())]].name;
+        print.Measure([&] { service.PrintSpecTree(name); });
+    }
+
+    for (std::size_t i = 0; i < opts.repeat; i++)
+        roots.Measure([&] { service.ListSpecificationRoots(); });
+
+    for (std::size_t i = 0; i < opts.repeat; i++)
+        truncate.Measure([&] { service.Truncate(); });
+
+    service.Close();
+
+    return { input, link, findHit, findMiss, cycle, print, roots, truncate };
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        ps::ConfigureConsoleForCyrillic();
+
+        const auto opts = ParseArgs(argc, argv);
+        if (opts.help)
+        {
+            Write(UsageText);
+            return 0;
+        }
+
+        const auto plan = GenerateCatalog(opts.catalog);
+        char sharing[32];
+        std::snprintf(sharing, sizeof(sharing), "%.2f", opts.catalog.sharing);
+        Write("Каталог: " + std::to_string(plan.components.size()) + " компонентов, " + std::to_string(plan.links.size()) +
+              " связей; уровней " + std::to_string(opts.catalog.depth) + ", fanout " + std::to_string(opts.catalog.fanout) +
+              ", sharing " + sharing + ", имя " + std::to_string(plan.maxNameLen) +
+              " байт, seed " + std::to_string(opts.catalog.seed) + ", хранилище " + ToString(opts.backend) + "\n\n");
+
+        RemoveCatalogFiles(opts);
+        std::vector<LatencySeries> report;
+        try
+        {
+            report = RunBenchmarks(opts, plan);
+        }
+        catch (...)
+        {
+            if (!opts.keepFiles) RemoveCatalogFiles(opts);
+            throw;
+        }
+        if (!opts.keepFiles) RemoveCatalogFiles(opts);
+
+        Write(FormatReport(report));
+    }
+    catch (const PsException& ex)
+    {
+        ps::ConsoleWriteErrW(L"Ошибка: ");
+        ps::ConsoleWriteErrW(Utf8ToWide(ex.what()));
+        ps::ConsoleWriteErrW(L"\n");
+        return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        ps::ConsoleWriteErrW(L"Критическая ошибка: ");
+        ps::ConsoleWriteErrW(Utf8ToWide(ex.what()));
+        ps::ConsoleWriteErrW(L"\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,81 +1,114 @@
 #include "BinaryIO.h"
-#include <fstream>
+#include "OperationStats.h"
+#include "Profiling.h"
 
 namespace ps
 {
-    void BinaryFile::OpenRW(const std::string& path)
+    void BinaryFile::OpenRW(const std::string& path, StorageBackend backend)
     {
         Close();
-        m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
-        if (!m_stream) throw FileException("Не удалось открыть файл: " + path);
+        m_storage = CreateStorage(backend);
+        m_backend = backend;
+        m_storage->Open(path, false);
+        m_pos = 0;
+        m_nextOffset = 0;
+        m_size = m_storage->Size();
     }
 
-    void BinaryFile::CreateRWTruncate(const std::string& path)
+    void BinaryFile::CreateRWTruncate(const std::string& path, StorageBackend backend)
     {
         Close();
-        m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
-        if (!m_stream)
-        {
-            std::ofstream tmp(path, std::ios::binary | std::ios::trunc);
-            if (!tmp) throw FileException("Не удалось создать файл: " + path);
-            tmp.close();
-
-            m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
-            if (!m_stream) throw FileException("Не удалось открыть созданный файл: " + path);
-        }
+        m_storage = CreateStorage(backend);
+        m_backend = backend;
+        m_storage->Open(path, true);
+        m_pos = 0;
+        m_nextOffset = 0;
+        m_size = 0;
     }
 
     void BinaryFile::Close()
     {
-        if (m_stream.is_open())
+        if (m_storage)
         {
-            m_stream.flush();
-            m_stream.close();
+            m_storage->Close();
+            m_storage.reset();
         }
+        m_size = 0;
     }
 
-    bool BinaryFile::IsOpen() const { return m_stream.is_open(); }
+    bool BinaryFile::IsOpen() const { return m_storage && m_storage->IsOpen(); }
+    StorageBackend BinaryFile::Backend() const { return m_backend; }
+
+    IStorage& BinaryFile::Storage()
+    {
+        if (!IsOpen()) throw FileException("Файл не открыт.");
+        return *m_storage;
+    }
 
     std::uint64_t BinaryFile::Size()
     {
-        auto cur = m_stream.tellg();
-        m_stream.seekg(0, std::ios::end);
-        auto end = m_stream.tellg();
-        m_stream.seekg(cur);
-        m_stream.seekp(cur);
-        return static_cast<std::uint64_t>(end);
+        Storage();
+        return m_size;
     }
 
-    void BinaryFile::Seek(std::uint64_t pos)
+    void BinaryFile::SyncSize() { m_size = Storage().Size(); }
+
+    void BinaryFile::Seek(std::uint64_t pos) { m_pos = pos; }
+    std::uint64_t BinaryFile::Tell() { return m_pos; }
+
+    void BinaryFile::Flush()
     {
-        m_stream.seekg(static_cast<std::streamoff>(pos), std::ios::beg);
-        m_stream.seekp(static_cast<std::streamoff>(pos), std::ios::beg);
-        if (!m_stream) throw FileException("Ошибка позиционирования в файле.");
+        PS_PROFILE_SPAN("BinaryFile::Flush");
+        Storage().Flush();
+        CountOperation(OperationCounter::Flushes);
     }
 
-    std::uint64_t BinaryFile::Tell()
+    void BinaryFile::Reserve(std::uint64_t size)
     {
-        auto p = m_stream.tellp();
-        if (p < 0) throw FileException("Ошибка получения позиции в файле.");
-        return static_cast<std::uint64_t>(p);
+        auto& storage = Storage();
+        storage.Reserve(size);
+        m_size = storage.Size();
     }
 
-    void BinaryFile::Flush()
+    void BinaryFile::Truncate(std::uint64_t size)
+    {
+        Storage().Truncate(size);
+        m_size = size;
+    }
+
+    void BinaryFile::NoteAccess(std::uint64_t offset, std::size_t size)
+    {
+        if (offset != m_nextOffset) CountOperation(OperationCounter::Seeks);
+        m_nextOffset = offset + size;
+    }
+
+    void BinaryFile::ReadAt(std::uint64_t offset, void* data, std::size_t size)
+    {
+        Storage().ReadAt(offset, data, size);
+        NoteAccess(offset, size);
+        CountOperation(OperationCounter::Reads);
+        CountOperation(OperationCounter::BytesRead, size);
+    }
+
+    void BinaryFile::WriteAt(std::uint64_t offset, const void* data, std::size_t size)
     {
-        m_stream.flush();
-        if (!m_stream) throw FileException("Ошибка flush().");
+        Storage().WriteAt(offset, data, size);
+        NoteAccess(offset, size);
+        CountOperation(OperationCounter::Writes);
+        CountOperation(OperationCounter::BytesWritten, size);
+        if (offset + size > m_size) m_size = offset + size;
     }
 
     void BinaryFile::WriteBytes(const void* data, std::size_t size)
     {
-        m_stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
-        if (!m_stream) throw FileException("Ошибка записи байтов в файл.");
+        WriteAt(m_pos, data, size);
+        m_pos += size;
     }
 
     void BinaryFile::ReadBytes(void* data, std::size_t size)
     {
-        m_stream.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
-        if (!m_stream) throw FileException("Ошибка чтения байтов из файла.");
+        ReadAt(m_pos, data, size);
+        m_pos += size;
     }
 
     void BinaryFile::WriteFixedString(const std::string& value, std::size_t fixedLen, char pad)
@@ -1,43 +1,58 @@
 #pragma once
 #include <cstdint>
-#include <fstream>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include "Errors.h"
+#include "Storage.h"
 
 namespace ps
 {
+    // Двоичный файл поверх выбранного хранилища (см. Storage.h).
+    // ReadAt/WriteAt обращаются к хранилищу напрямую по смещению; курсорные
+    // Seek/ReadBytes/WriteBytes оставлены для последовательного разбора.
+    // Размер файла запоминается при открытии и растёт вместе с записью,
+    // поэтому Size() не обращается к ОС.
+    // Обращения к хранилищу учитываются в счётчиках OperationStats.h.
     class BinaryFile final
     {
     public:
-        void OpenRW(const std::string& path);
-        void CreateRWTruncate(const std::string& path);
+        void OpenRW(const std::string& path, StorageBackend backend = DefaultStorageBackend);
+        void CreateRWTruncate(const std::string& path, StorageBackend backend = DefaultStorageBackend);
         void Close();
 
         bool IsOpen() const;
+        StorageBackend Backend() const;
 
         std::uint64_t Size();
+        // перечитать размер у хранилища: файл мог изменить другой процесс
+        void SyncSize();
         void Seek(std::uint64_t pos);
         std::uint64_t Tell();
 
         void Flush();
 
+        // см. IStorage::Reserve / IStorage::Truncate
+        void Reserve(std::uint64_t size);
+        void Truncate(std::uint64_t size);
+
         template<typename T>
         void WriteLE(const T& v)
         {
             static_assert(std::is_trivially_copyable_v<T>);
-            m_stream.write(reinterpret_cast<const char*>(&v), sizeof(T));
-            if (!m_stream) throw FileException("Ошибка записи в файл.");
+            WriteBytes(&v, sizeof(T));
         }
 
         template<typename T>
         void ReadLE(T& v)
         {
             static_assert(std::is_trivially_copyable_v<T>);
-            m_stream.read(reinterpret_cast<char*>(&v), sizeof(T));
-            if (!m_stream) throw FileException("Ошибка чтения из файла.");
+            ReadBytes(&v, sizeof(T));
         }
 
+        void ReadAt(std::uint64_t offset, void* data, std::size_t size);
+        void WriteAt(std::uint64_t offset, const void* data, std::size_t size);
+
         void WriteBytes(const void* data, std::size_t size);
         void ReadBytes(void* data, std::size_t size);
 
@@ -45,6 +60,14 @@ namespace ps
         std::string ReadFixedString(std::size_t fixedLen);
 
     private:
-        std::fstream m_stream;
+        std::unique_ptr<IStorage> m_storage;
+        StorageBackend m_backend = DefaultStorageBackend;
+        std::uint64_t m_pos = 0;
+        std::uint64_t m_size = 0;
+        std::uint64_t m_nextOffset = 0; // где кончилось прошлое обращение к хранилищу
+
+        IStorage& Storage();
+        // обращение не с того места, где кончилось предыдущее, — позиционирование
+        void NoteAccess(std::uint64_t offset, std::size_t size);
     };
 }
@@ -0,0 +1,58 @@
+#include "BloomFilter.h"
+#include <algorithm>
+
+namespace ps
+{
+    // FNV-1a, 64 бита; из одного хэша получаются все HashCount (двойное хэширование)
+    static std::uint64_t Hash(std::string_view s)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : s)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    void BloomFilter::Reset(std::size_t expectedItems)
+    {
+        m_capacity = std::max<std::size_t>(expectedItems, 64);
+        m_bitCount = static_cast<std::uint64_t>(m_capacity) * BitsPerItem;
+        m_bits.assign(static_cast<std::size_t>((m_bitCount + 63) / 64), 0);
+        m_added = 0;
+    }
+
+    void BloomFilter::Add(std::string_view s)
+    {
+        if (m_bits.empty()) Reset(0);
+
+        const auto h = Hash(s);
+        const auto h1 = h;
+        const auto h2 = (h >> 32 | h << 32) | 1;
+        for (std::size_t i = 0; i < HashCount; i++)
+        {
+            const auto bit = (h1 + i * h2) % m_bitCount;
+            m_bits[bit / 64] |= 1ull << (bit % 64);
+        }
+        m_added++;
+    }
+
+    bool BloomFilter::MayContain(std::string_view s) const
+    {
+        if (m_bits.empty()) return false;
+
+        const auto h = Hash(s);
+        const auto h1 = h;
+        const auto h2 = (h >> 32 | h << 32) | 1;
+        for (std::size_t i = 0; i < HashCount; i++)
+        {
+            const auto bit = (h1 + i * h2) % m_bitCount;
+            if ((m_bits[bit / 64] & (1ull << (bit % 64))) == 0) return false;
+        }
+        return true;
+    }
+
+    bool BloomFilter::Saturated() const { return m_added > m_capacity; }
+    std::size_t BloomFilter::Capacity() const { return m_capacity; }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ps
+{
+    // Фильтр Блума над строками: MayContain() == false означает, что строка
+    // точно не добавлялась; true — "возможно, добавлялась" (нужна точная проверка).
+    // Удаление не поддерживается: удалённые строки лишь дают ложные срабатывания,
+    // пока владелец не пересоберёт фильтр.
+    class BloomFilter final
+    {
+    public:
+        static constexpr std::size_t BitsPerItem = 10;
+        static constexpr std::size_t HashCount = 7; // ~1% ложных срабатываний при BitsPerItem = 10
+
+        // очистить и подготовить под expectedItems строк
+        void Reset(std::size_t expectedItems);
+
+        void Add(std::string_view s);
+        bool MayContain(std::string_view s) const;
+
+        // добавлено больше строк, чем рассчитано: доля ложных срабатываний растёт
+        bool Saturated() const;
+        std::size_t Capacity() const;
+
+    private:
+        std::vector<std::uint64_t> m_bits;
+        std::uint64_t m_bitCount = 0;
+        std::size_t m_capacity = 0;
+        std::size_t m_added = 0;
+    };
+}
@@ -21,4 +21,11 @@ namespace ps
     public:
         explicit ValidationException(const std::string& message) : PsException(message) {}
     };
+
+    // операция прервана по запросу (см. Progress::Cancelled)
+    class OperationCancelled final : public PsException
+    {
+    public:
+        OperationCancelled() : PsException("Операция отменена.") {}
+    };
 }
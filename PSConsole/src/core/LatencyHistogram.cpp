@@ -0,0 +1,64 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ps
+{
+    static constexpr unsigned SubBucketBits = 5;
+    static constexpr std::uint64_t SubBuckets = 1u << SubBucketBits;
+
+    static unsigned HighestBit(std::uint64_t v)
+    {
+        unsigned bit = 0;
+        while (v >>= 1) bit++;
+        return bit;
+    }
+
+    // значения до 32 лежат в своих корзинах, дальше — 32 корзины на степень двойки
+    static std::size_t BucketOf(std::uint64_t v)
+    {
+        if (v < SubBuckets) return static_cast<std::size_t>(v);
+        const auto bit = HighestBit(v);
+        return static_cast<std::size_t>((bit - SubBucketBits + 1) * SubBuckets + ((v >> (bit - SubBucketBits)) & (SubBuckets - 1)));
+    }
+
+    static std::uint64_t BucketUpperBound(std::size_t bucket)
+    {
+        const auto range = bucket >> SubBucketBits;
+        const auto sub = bucket & (SubBuckets - 1);
+        if (range == 0) return sub;
+
+        const auto shift = range - 1;
+        return ((SubBuckets + sub) << shift) + ((std::uint64_t{ 1 } << shift) - 1);
+    }
+
+    void LatencyHistogram::Record(std::uint64_t ns)
+    {
+        const auto bucket = BucketOf(ns);
+        if (m_counts.size() <= bucket) m_counts.resize(bucket + 1);
+        m_counts[bucket]++;
+        m_count++;
+        m_total += ns;
+        m_max = std::max(m_max, ns);
+    }
+
+    void LatencyHistogram::Reset() { *this = LatencyHistogram{}; }
+
+    std::uint64_t LatencyHistogram::Count() const { return m_count; }
+    std::uint64_t LatencyHistogram::TotalNs() const { return m_total; }
+    std::uint64_t LatencyHistogram::MaxNs() const { return m_max; }
+
+    std::uint64_t LatencyHistogram::PercentileNs(double p) const
+    {
+        if (m_count == 0) return 0;
+
+        const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(m_count))));
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < m_counts.size(); b++)
+        {
+            seen += m_counts[b];
+            if (seen >= rank) return std::min(BucketUpperBound(b), m_max);
+        }
+        return m_max;
+    }
+}
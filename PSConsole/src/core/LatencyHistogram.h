@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace ps
+{
+    // Гистограмма задержек по схеме HdrHistogram: диапазоны [2^k, 2^(k+1))
+    // делятся на 32 равные корзины, поэтому значение известно с точностью
+    // около 3% при любом разбросе, а память не зависит от числа замеров
+    // (не больше 1920 корзин, выделяются по мере надобности).
+    class LatencyHistogram final
+    {
+    public:
+        void Record(std::uint64_t ns);
+        void Reset();
+
+        std::uint64_t Count() const;
+        std::uint64_t TotalNs() const;
+        std::uint64_t MaxNs() const;
+        // p от 0 до 100: верхняя граница корзины, где набирается доля p, но
+        // не больше максимума; 0 для пустой гистограммы
+        std::uint64_t PercentileNs(double p) const;
+
+    private:
+        std::vector<std::uint64_t> m_counts;
+        std::uint64_t m_count = 0;
+        std::uint64_t m_total = 0;
+        std::uint64_t m_max = 0;
+    };
+}
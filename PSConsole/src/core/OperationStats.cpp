@@ -0,0 +1,41 @@
+#include "OperationStats.h"
+#include <atomic>
+
+namespace ps
+{
+    static constexpr std::size_t CounterCount = static_cast<std::size_t>(OperationCounter::None);
+
+    static std::atomic<std::uint64_t> g_counters[CounterCount];
+
+    OperationCounters OperationCounters::operator-(const OperationCounters& earlier) const
+    {
+        OperationCounters d;
+        for (std::size_t i = 0; i < CounterCount; i++)
+            d.values[i] = values[i] > earlier.values[i] ? values[i] - earlier.values[i] : 0;
+        return d;
+    }
+
+    OperationCounters& OperationCounters::operator+=(const OperationCounters& other)
+    {
+        for (std::size_t i = 0; i < CounterCount; i++) values[i] += other.values[i];
+        return *this;
+    }
+
+    void CountOperation(OperationCounter counter, std::uint64_t n)
+    {
+        if (counter == OperationCounter::None) return;
+        g_counters[static_cast<std::size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    OperationCounters ReadOperationCounters()
+    {
+        OperationCounters c;
+        for (std::size_t i = 0; i < CounterCount; i++) c.values[i] = g_counters[i].load(std::memory_order_relaxed);
+        return c;
+    }
+
+    void ResetOperationCounters()
+    {
+        for (auto& c : g_counters) c.store(0, std::memory_order_relaxed);
+    }
+}
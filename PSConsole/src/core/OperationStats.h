@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+namespace ps
+{
+    // Счётчики обращений к хранилищу (BinaryFile) и к записям каталога
+    // (ProductFile, SpecFile) с запуска процесса или с ResetOperationCounters.
+    // Общие для всех файлов; увеличиваются атомарно, поэтому годятся и для
+    // операций, идущих в рабочем потоке.
+    enum class OperationCounter : std::uint8_t
+    {
+        Seeks,          // обращений не с того места, где кончилось предыдущее в этом файле
+        Reads,          // обращений к хранилищу на чтение
+        Writes,         // обращений к хранилищу на запись
+        BytesRead,
+        BytesWritten,
+        Flushes,
+        ProductReads,   // записей .prd прочитано
+        ProductWrites,  // записей .prd записано
+        SpecReads,      // записей .prs прочитано
+        SpecWrites,     // записей .prs записано
+        None            // не считать (см. RecordFile)
+    };
+
+    struct OperationCounters
+    {
+        std::uint64_t values[static_cast<std::size_t>(OperationCounter::None)] = {};
+
+        std::uint64_t operator[](OperationCounter c) const { return values[static_cast<std::size_t>(c)]; }
+
+        // разность снимков; счётчик, сброшенный между снимками, даёт 0
+        OperationCounters operator-(const OperationCounters& earlier) const;
+        OperationCounters& operator+=(const OperationCounters& other);
+    };
+
+    void CountOperation(OperationCounter counter, std::uint64_t n = 1);
+    OperationCounters ReadOperationCounters();
+    void ResetOperationCounters();
+}
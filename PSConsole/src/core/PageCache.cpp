@@ -0,0 +1,156 @@
+#include "PageCache.h"
+#include <algorithm>
+
+namespace ps
+{
+    PageCache::PageCache(std::size_t capacityPages) : m_capacity(std::max<std::size_t>(capacityPages, 1)) {}
+
+    std::uint64_t PageCache::Key(FileId id, std::uint64_t pageNo)
+    {
+        return (static_cast<std::uint64_t>(id) << 40) | pageNo;
+    }
+
+    PageCache::FileId PageCache::Attach(BinaryFile& file, std::uint64_t physSize)
+    {
+        auto id = m_nextId++;
+        auto& entry = m_files[id];
+        entry.file = &file;
+        entry.physSize = physSize;
+        entry.logicalSize = physSize;
+        return id;
+    }
+
+    void PageCache::Detach(FileId id)
+    {
+        auto it = m_files.find(id);
+        if (it == m_files.end()) return;
+
+        Flush(id);
+
+        for (auto f = m_lru.begin(); f != m_lru.end();)
+        {
+            if (f->file == id)
+            {
+                m_index.erase(Key(f->file, f->pageNo));
+                f = m_lru.erase(f);
+            }
+            else ++f;
+        }
+        m_files.erase(it);
+    }
+
+    void PageCache::SetLogicalSize(FileId id, std::uint64_t size)
+    {
+        m_files.at(id).logicalSize = size;
+    }
+
+    const std::uint8_t* PageCache::Page(FileId id, std::uint64_t pageNo)
+    {
+        return Fetch(id, pageNo).data.data();
+    }
+
+    std::uint8_t* PageCache::PageForWrite(FileId id, std::uint64_t pageNo)
+    {
+        auto& frame = Fetch(id, pageNo);
+        if (!frame.dirty)
+        {
+            frame.dirty = true;
+            m_files.at(id).dirtyPages.insert(pageNo);
+        }
+        return frame.data.data();
+    }
+
+    void PageCache::Flush(FileId id)
+    {
+        auto& entry = m_files.at(id);
+        if (entry.dirtyPages.empty()) return;
+
+        // WriteBack удаляет номер из dirtyPages, поэтому идём по копии
+        const auto pages = entry.dirtyPages;
+        for (auto pageNo : pages)
+            WriteBack(*m_index.at(Key(id, pageNo)));
+
+        entry.file->Flush();
+    }
+
+    void PageCache::SetCapacity(std::size_t capacityPages)
+    {
+        m_capacity = std::max<std::size_t>(capacityPages, 1);
+        while (m_lru.size() > m_capacity) EvictOne();
+    }
+
+    std::size_t PageCache::Capacity() const { return m_capacity; }
+    std::size_t PageCache::CachedPages() const { return m_lru.size(); }
+
+    const PageCache::Stats& PageCache::GetStats() const { return m_stats; }
+    void PageCache::ResetStats() { m_stats = Stats{}; }
+
+    PageCache::Frame& PageCache::Fetch(FileId id, std::uint64_t pageNo)
+    {
+        const auto key = Key(id, pageNo);
+        auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            m_stats.hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return m_lru.front();
+        }
+
+        m_stats.misses++;
+
+        // буфер вытесненной страницы переиспользуется для новой
+        Frame frame;
+        if (m_lru.size() >= m_capacity) frame.data = EvictOne();
+
+        frame.file = id;
+        frame.pageNo = pageNo;
+        Load(frame);
+
+        m_lru.push_front(std::move(frame));
+        m_index[key] = m_lru.begin();
+        return m_lru.front();
+    }
+
+    void PageCache::Load(Frame& frame)
+    {
+        frame.data.assign(PageSize, 0);
+
+        auto& entry = m_files.at(frame.file);
+        const auto start = frame.pageNo * PageSize;
+        if (start < entry.physSize)
+        {
+            const auto n = std::min<std::uint64_t>(PageSize, entry.physSize - start);
+            entry.file->ReadAt(start, frame.data.data(), static_cast<std::size_t>(n));
+        }
+    }
+
+    void PageCache::WriteBack(Frame& frame)
+    {
+        if (!frame.dirty) return;
+
+        auto& entry = m_files.at(frame.file);
+        const auto start = frame.pageNo * PageSize;
+        if (start < entry.logicalSize)
+        {
+            const auto n = std::min<std::uint64_t>(PageSize, entry.logicalSize - start);
+            entry.file->WriteAt(start, frame.data.data(), static_cast<std::size_t>(n));
+            entry.physSize = std::max(entry.physSize, start + n);
+            m_stats.writeBacks++;
+        }
+
+        frame.dirty = false;
+        entry.dirtyPages.erase(frame.pageNo);
+    }
+
+    std::vector<std::uint8_t> PageCache::EvictOne()
+    {
+        auto& victim = m_lru.back();
+        WriteBack(victim);
+        m_index.erase(Key(victim.file, victim.pageNo));
+
+        auto data = std::move(victim.data);
+        m_lru.pop_back();
+        m_stats.evictions++;
+        return data;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "BinaryIO.h"
+
+namespace ps
+{
+    // Кэш страниц фиксированного размера между BinaryFile и файлами записей.
+    // Один экземпляр может обслуживать несколько файлов (.prd и .prs каталога):
+    // страницы разных файлов конкурируют за общую ёмкость, вытесняется давно
+    // не использованная (LRU). Изменённые страницы помечаются грязными и пишутся
+    // на диск в Flush(файл) или при вытеснении.
+    class PageCache final
+    {
+    public:
+        static constexpr std::size_t PageSize = 4096;
+        static constexpr std::size_t DefaultCapacity = 256; // страниц (1 МиБ)
+
+        using FileId = std::uint32_t;
+
+        struct Stats
+        {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+            std::uint64_t writeBacks = 0;
+        };
+
+        explicit PageCache(std::size_t capacityPages = DefaultCapacity);
+
+        PageCache(const PageCache&) = delete;
+        PageCache& operator=(const PageCache&) = delete;
+
+        // Подключить открытый файл. physSize — текущий размер файла на диске.
+        FileId Attach(BinaryFile& file, std::uint64_t physSize);
+        // Сбросить грязные страницы файла и убрать его страницы из кэша.
+        void Detach(FileId id);
+
+        // Логический конец файла: хвост последней страницы за ним на диск не пишется.
+        void SetLogicalSize(FileId id, std::uint64_t size);
+
+        // Указатель на страницу действителен до следующего обращения к кэшу.
+        const std::uint8_t* Page(FileId id, std::uint64_t pageNo);
+        std::uint8_t* PageForWrite(FileId id, std::uint64_t pageNo);
+
+        // Записать грязные страницы файла по возрастанию номера и сделать flush().
+        void Flush(FileId id);
+
+        void SetCapacity(std::size_t capacityPages);
+        std::size_t Capacity() const;
+        std::size_t CachedPages() const;
+
+        const Stats& GetStats() const;
+        void ResetStats();
+
+    private:
+        struct Frame
+        {
+            FileId file = 0;
+            std::uint64_t pageNo = 0;
+            bool dirty = false;
+            std::vector<std::uint8_t> data;
+        };
+
+        struct FileEntry
+        {
+            BinaryFile* file = nullptr;
+            std::uint64_t physSize = 0;
+            std::uint64_t logicalSize = 0;
+            std::set<std::uint64_t> dirtyPages;
+        };
+
+        using FrameList = std::list<Frame>;
+
+        static std::uint64_t Key(FileId id, std::uint64_t pageNo);
+
+        Frame& Fetch(FileId id, std::uint64_t pageNo);
+        void Load(Frame& frame);
+        void WriteBack(Frame& frame);
+        std::vector<std::uint8_t> EvictOne(); // возвращает буфер вытесненной страницы
+
+        std::size_t m_capacity;
+        FrameList m_lru; // начало списка — самые свежие страницы
+        std::unordered_map<std::uint64_t, FrameList::iterator> m_index;
+        std::unordered_map<FileId, FileEntry> m_files;
+        FileId m_nextId = 1;
+        Stats m_stats;
+    };
+}
@@ -0,0 +1,119 @@
+#include "PagedFile.h"
+#include <algorithm>
+
+namespace ps
+{
+    void PagedFile::UseCache(PageCache* cache)
+    {
+        m_cache = cache;
+        if (cache) m_ownCache.reset();
+    }
+
+    void PagedFile::Create(const std::string& path, StorageBackend backend)
+    {
+        Close();
+        m_file.CreateRWTruncate(path, backend);
+        m_size = 0;
+        m_reserved = 0;
+        AttachCache(0);
+    }
+
+    void PagedFile::Open(const std::string& path, StorageBackend backend)
+    {
+        Close();
+        m_file.OpenRW(path, backend);
+        m_size = m_file.Size();
+        m_reserved = m_size;
+        AttachCache(m_size);
+    }
+
+    void PagedFile::Close()
+    {
+        if (m_file.IsOpen())
+        {
+            m_cache->Detach(m_cacheId);
+            if (m_file.Size() > m_size) m_file.Truncate(m_size);
+        }
+        m_file.Close();
+    }
+
+    void PagedFile::Reload()
+    {
+        m_cache->Detach(m_cacheId);
+        m_file.SyncSize();
+        m_size = m_file.Size();
+        m_reserved = m_size;
+        AttachCache(m_size);
+    }
+
+    bool PagedFile::IsOpen() const { return m_file.IsOpen(); }
+    StorageBackend PagedFile::Backend() const { return m_file.Backend(); }
+
+    std::uint64_t PagedFile::Size() const { return m_size; }
+
+    void PagedFile::SetSize(std::uint64_t size)
+    {
+        m_size = size;
+        m_cache->SetLogicalSize(m_cacheId, m_size);
+    }
+
+    void PagedFile::Read(std::uint64_t pos, void* dst, std::size_t size)
+    {
+        if (pos + size > m_size) throw FileException("Ошибка чтения из файла.");
+
+        auto* out = static_cast<std::uint8_t*>(dst);
+        while (size > 0)
+        {
+            const auto* page = m_cache->Page(m_cacheId, pos / PageSize);
+            const auto inPage = static_cast<std::size_t>(pos % PageSize);
+            const auto n = std::min(size, PageSize - inPage);
+            std::copy_n(page + inPage, n, out);
+            pos += n;
+            out += n;
+            size -= n;
+        }
+    }
+
+    void PagedFile::Write(std::uint64_t pos, const void* src, std::size_t size)
+    {
+        if (pos + size > m_size)
+        {
+            SetSize(pos + size);
+            Grow(m_size);
+        }
+
+        const auto* in = static_cast<const std::uint8_t*>(src);
+        while (size > 0)
+        {
+            auto* page = m_cache->PageForWrite(m_cacheId, pos / PageSize);
+            const auto inPage = static_cast<std::size_t>(pos % PageSize);
+            const auto n = std::min(size, PageSize - inPage);
+            std::copy_n(in, n, page + inPage);
+            pos += n;
+            in += n;
+            size -= n;
+        }
+    }
+
+    void PagedFile::ReadStored(std::uint64_t pos, void* dst, std::size_t size) { m_file.ReadAt(pos, dst, size); }
+
+    void PagedFile::Flush() { m_cache->Flush(m_cacheId); }
+
+    void PagedFile::AttachCache(std::uint64_t physSize)
+    {
+        if (!m_cache)
+        {
+            m_ownCache = std::make_unique<PageCache>();
+            m_cache = m_ownCache.get();
+        }
+        m_cacheId = m_cache->Attach(m_file, physSize);
+    }
+
+    void PagedFile::Grow(std::uint64_t end)
+    {
+        if (end <= m_reserved) return;
+        const auto extent = std::max(MinExtent, m_reserved / 4);
+        m_reserved = (end + extent + PageSize - 1) / PageSize * PageSize;
+        m_file.Reserve(m_reserved);
+    }
+}
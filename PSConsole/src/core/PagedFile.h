@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "BinaryIO.h"
+#include "PageCache.h"
+
+namespace ps
+{
+    // Файл, весь ввод-вывод которого идёт страницами через PageCache: изменения
+    // копятся в "грязных" страницах и сбрасываются на диск в Flush() (или при
+    // вытеснении страницы из кэша). Кэш можно разделить между несколькими файлами
+    // (UseCache); без этого файл заводит собственный кэш ёмкостью по умолчанию.
+    //
+    // Логический размер (Size) может быть меньше физического: при дописывании
+    // место выделяется экстентами (не меньше MinExtent и с ростом на четверть),
+    // лишний хвост отрезается в Close(). Владелец файла узнаёт логический конец
+    // из своего заголовка и сообщает его через SetSize() после Open().
+    class PagedFile final
+    {
+    public:
+        static constexpr std::size_t PageSize = PageCache::PageSize;
+        static constexpr std::uint64_t MinExtent = 64 * 1024;
+
+        // вызывать до Create/Open; кэш должен пережить файл
+        void UseCache(PageCache* cache);
+
+        void Create(const std::string& path, StorageBackend backend);
+        // после открытия логический размер равен физическому
+        void Open(const std::string& path, StorageBackend backend);
+        void Close();
+        // Отбросить страницы файла в кэше и перечитать его размер: файл изменил
+        // другой процесс. Свои изменения к этому моменту должны быть сброшены (Flush),
+        // логический размер после вызова снова равен физическому.
+        void Reload();
+
+        bool IsOpen() const;
+        StorageBackend Backend() const;
+
+        std::uint64_t Size() const;
+        void SetSize(std::uint64_t size);
+
+        void Read(std::uint64_t pos, void* dst, std::size_t size);
+        // запись за логическим концом расширяет файл
+        void Write(std::uint64_t pos, const void* src, std::size_t size);
+        // прочитать байты с диска мимо кэша (как их видят другие процессы)
+        void ReadStored(std::uint64_t pos, void* dst, std::size_t size);
+
+        void Flush();
+
+    private:
+        BinaryFile m_file;
+
+        std::uint64_t m_size = 0;     // логический конец файла
+        std::uint64_t m_reserved = 0; // выделено на диске
+
+        PageCache* m_cache = nullptr;
+        std::unique_ptr<PageCache> m_ownCache;
+        PageCache::FileId m_cacheId = 0;
+
+        void AttachCache(std::uint64_t physSize);
+        void Grow(std::uint64_t end);
+    };
+}
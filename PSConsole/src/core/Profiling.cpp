@@ -0,0 +1,162 @@
+#include "Profiling.h"
+#include "Errors.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ps
+{
+    // Больше событий не копится: Truncate большого каталога даёт миллионы
+    // чтений записей. Отброшенные события учитываются в otherData.
+    static constexpr std::size_t MaxEvents = std::size_t{ 1 } << 20;
+
+    static std::int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class ProfileSession final
+    {
+    public:
+        ~ProfileSession() { Stop(); }
+
+        bool Active() const { return m_active.load(std::memory_order_relaxed); }
+
+        void Start(const std::string& path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteLocked();
+
+            m_out.open(path, std::ios::binary | std::ios::trunc);
+            if (!m_out) throw FileException("Не удалось создать файл профиля: " + path);
+            m_path = path;
+            m_events.clear();
+            m_threads.clear();
+            m_dropped = 0;
+            m_startNs = NowNs();
+            m_active.store(true, std::memory_order_relaxed);
+        }
+
+        void Stop()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteLocked();
+        }
+
+        void Add(const char* name, std::int64_t startNs, std::int64_t stopNs)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // интервал начат до нынешней записи
+            if (!Active() || startNs < m_startNs) return;
+            if (m_events.size() >= MaxEvents)
+            {
+                m_dropped++;
+                return;
+            }
+
+            const auto thread = m_threads.emplace(std::this_thread::get_id(), static_cast<std::uint32_t>(m_threads.size() + 1)).first->second;
+            m_events.push_back({ name, startNs - m_startNs, stopNs - startNs, thread });
+        }
+
+    private:
+        struct Event
+        {
+            const char* name;
+            std::int64_t startNs;
+            std::int64_t durationNs;
+            std::uint32_t thread;
+        };
+
+        std::mutex m_mutex;
+        std::atomic<bool> m_active{ false };
+        std::string m_path;
+        std::ofstream m_out;
+        std::int64_t m_startNs = 0;
+        std::vector<Event> m_events;
+        std::unordered_map<std::thread::id, std::uint32_t> m_threads;
+        std::uint64_t m_dropped = 0;
+
+        static void WriteName(std::ofstream& out, const char* name)
+        {
+            out << '"';
+            for (const char* p = name; *p; p++)
+            {
+                if (*p == '"' || *p == '\\') out << '\\';
+                out << *p;
+            }
+            out << '"';
+        }
+
+        // ts и dur — микросекунды; дробная часть сохраняет наносекунды
+        static void WriteMicroseconds(std::ofstream& out, std::int64_t ns)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(ns / 1000), static_cast<long long>(ns % 1000));
+            out << buf;
+        }
+
+        void WriteLocked()
+        {
+            if (!Active()) return;
+            m_active.store(false, std::memory_order_relaxed);
+
+            m_out << "{\"traceEvents\":[\n";
+            for (std::size_t i = 0; i < m_events.size(); i++)
+            {
+                const auto& e = m_events[i];
+                m_out << "{\"name\":";
+                WriteName(m_out, e.name);
+                m_out << ",\"cat\":\"ps\",\"ph\":\"X\",\"ts\":";
+                WriteMicroseconds(m_out, e.startNs);
+                m_out << ",\"dur\":";
+                WriteMicroseconds(m_out, e.durationNs);
+                m_out << ",\"pid\":1,\"tid\":" << e.thread << '}' << (i + 1 < m_events.size() ? ",\n" : "\n");
+            }
+            m_out << "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":\"" << m_dropped << "\"}}\n";
+            m_out.close();
+
+            m_events.clear();
+            m_events.shrink_to_fit();
+            m_threads.clear();
+        }
+    };
+
+    static ProfileSession& Session()
+    {
+        static ProfileSession session;
+        return session;
+    }
+
+    void StartProfiling(const std::string& path)
+    {
+        if (!ProfilingCompiledIn)
+            throw ValidationException("Профилирование недоступно: программа собрана без PS_PROFILING (ENABLE_PROFILING).");
+        Session().Start(path);
+    }
+
+    void StartProfilingFromEnvironment()
+    {
+        const char* path = std::getenv("PS_PROFILE");
+        if (path != nullptr && *path != '\0') StartProfiling(path);
+    }
+
+    void StopProfiling() { Session().Stop(); }
+    bool ProfilingActive() { return Session().Active(); }
+
+    ProfileSpan::ProfileSpan(const char* name) : m_name(name)
+    {
+        if (Session().Active()) m_startNs = NowNs();
+    }
+
+    ProfileSpan::~ProfileSpan()
+    {
+        if (m_startNs >= 0) Session().Add(m_name, m_startNs, NowNs());
+    }
+}
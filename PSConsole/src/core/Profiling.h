@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace ps
+{
+    // Профиль в формате Chrome trace events (открывается в chrome://tracing или
+    // Perfetto): интервалы от PS_PROFILE_SPAN до конца области, с вложенностью
+    // по потокам. Интервалы есть только в сборке с PS_PROFILING (CMake:
+    // -DENABLE_PROFILING=ON); без него макрос пуст и ничего не стоит, а
+    // StartProfiling отвечает ValidationException.
+#if defined(PS_PROFILING)
+    inline constexpr bool ProfilingCompiledIn = true;
+#else
+    inline constexpr bool ProfilingCompiledIn = false;
+#endif
+
+    // Начать запись. Файл создаётся сразу (ошибка — FileException), события
+    // копятся в памяти и записываются в StopProfiling или при завершении процесса.
+    void StartProfiling(const std::string& path);
+    // PS_PROFILE=файл.json в окружении — то же, что StartProfiling(файл)
+    void StartProfilingFromEnvironment();
+    // записать события и закончить; без начатой записи ничего не делает
+    void StopProfiling();
+    bool ProfilingActive();
+
+    class ProfileSpan final
+    {
+    public:
+        // name — строковый литерал: хранится указатель
+        explicit ProfileSpan(const char* name);
+        ~ProfileSpan();
+
+        ProfileSpan(const ProfileSpan&) = delete;
+        ProfileSpan& operator=(const ProfileSpan&) = delete;
+
+    private:
+        const char* m_name;
+        std::int64_t m_startNs = -1; // -1: запись не шла
+    };
+}
+
+#if defined(PS_PROFILING)
+#define PS_PROFILE_CONCAT_(a, b) a##b
+#define PS_PROFILE_CONCAT(a, b) PS_PROFILE_CONCAT_(a, b)
+#define PS_PROFILE_SPAN(name) ::ps::ProfileSpan PS_PROFILE_CONCAT(psProfileSpan, __LINE__)(name)
+#else
+#define PS_PROFILE_SPAN(name) ((void)0)
+#endif
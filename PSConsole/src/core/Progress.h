@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+namespace ps
+{
+    // Наблюдатель долгой операции: ход выполнения и запрос отмены.
+    // Вызывается из потока, в котором идёт операция.
+    class Progress
+    {
+    public:
+        virtual ~Progress() = default;
+
+        // выполнено done шагов из total (total == 0 — объём заранее неизвестен)
+        virtual void Report(std::uint64_t done, std::uint64_t total) = 0;
+        // true — операция прерывается с OperationCancelled при следующей проверке
+        virtual bool Cancelled() const = 0;
+    };
+}
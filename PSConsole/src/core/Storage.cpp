@@ -0,0 +1,458 @@
+#include "Storage.h"
+#include "Errors.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+  #include "UtfConv.h"
+#else
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace ps
+{
+    std::string ToString(StorageBackend backend)
+    {
+        switch (backend)
+        {
+        case StorageBackend::Fstream: return "fstream";
+        case StorageBackend::Posix: return "posix";
+        case StorageBackend::Memory: return "memory";
+        default: return "unknown";
+        }
+    }
+
+    // ---- std::fstream ----
+
+    class FstreamStorage final : public IStorage
+    {
+    public:
+        void Open(const std::string& path, bool truncate) override
+        {
+            Close();
+            m_path = path;
+            if (!truncate)
+            {
+                m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
+                if (!m_stream) throw FileException("Не удалось открыть файл: " + path);
+                m_pos = NoPos;
+                return;
+            }
+
+            m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+            if (!m_stream)
+            {
+                std::ofstream tmp(path, std::ios::binary | std::ios::trunc);
+                if (!tmp) throw FileException("Не удалось создать файл: " + path);
+                tmp.close();
+
+                m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
+                if (!m_stream) throw FileException("Не удалось открыть созданный файл: " + path);
+            }
+            m_pos = NoPos;
+        }
+
+        void Close() override
+        {
+            if (m_stream.is_open())
+            {
+                m_stream.flush();
+                m_stream.close();
+            }
+        }
+
+        bool IsOpen() const override { return m_stream.is_open(); }
+
+        std::uint64_t Size() override
+        {
+            m_stream.seekg(0, std::ios::end);
+            auto end = m_stream.tellg();
+            if (end < 0) throw FileException("Ошибка получения размера файла.");
+            m_pos = static_cast<std::uint64_t>(end);
+            m_lastWrite = false;
+            return m_pos;
+        }
+
+        // У filebuf один указатель позиции на чтение и запись; позиционируемся только
+        // при разрыве последовательного доступа или смене чтения на запись (и наоборот).
+        void ReadAt(std::uint64_t offset, void* data, std::size_t size) override
+        {
+            if (m_pos != offset || m_lastWrite)
+                m_stream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+            m_stream.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+            if (!m_stream)
+            {
+                m_stream.clear();
+                m_pos = NoPos;
+                throw FileException("Ошибка чтения байтов из файла.");
+            }
+            m_pos = offset + size;
+            m_lastWrite = false;
+        }
+
+        void WriteAt(std::uint64_t offset, const void* data, std::size_t size) override
+        {
+            if (m_pos != offset || !m_lastWrite)
+                m_stream.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
+            m_stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!m_stream)
+            {
+                m_stream.clear();
+                m_pos = NoPos;
+                throw FileException("Ошибка записи байтов в файл.");
+            }
+            m_pos = offset + size;
+            m_lastWrite = true;
+        }
+
+        void Flush() override
+        {
+            m_stream.flush();
+            if (!m_stream) throw FileException("Ошибка flush().");
+        }
+
+        // у потоков нет переносимого способа выделить место заранее
+        void Reserve(std::uint64_t) override {}
+
+        void Truncate(std::uint64_t size) override
+        {
+            Flush();
+            std::error_code ec;
+            std::filesystem::resize_file(m_path, size, ec);
+            if (ec) throw FileException("Ошибка изменения размера файла.");
+            m_pos = NoPos;
+        }
+
+    private:
+        static constexpr std::uint64_t NoPos = ~0ull;
+
+        std::string m_path;
+        std::fstream m_stream;
+        std::uint64_t m_pos = NoPos;
+        bool m_lastWrite = false;
+    };
+
+    // ---- позиционный ввод-вывод ОС ----
+
+#if defined(_WIN32)
+    class PositionalStorage final : public IStorage
+    {
+    public:
+        ~PositionalStorage() override { Close(); }
+
+        void Open(const std::string& path, bool truncate) override
+        {
+            Close();
+            m_handle = CreateFileW(
+                Utf8ToWide(path).c_str(),
+                GENERIC_READ | GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                truncate ? CREATE_ALWAYS : OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr);
+            if (m_handle == INVALID_HANDLE_VALUE)
+                throw FileException((truncate ? "Не удалось создать файл: " : "Не удалось открыть файл: ") + path);
+        }
+
+        void Close() override
+        {
+            if (m_handle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_handle);
+                m_handle = INVALID_HANDLE_VALUE;
+            }
+        }
+
+        bool IsOpen() const override { return m_handle != INVALID_HANDLE_VALUE; }
+
+        std::uint64_t Size() override
+        {
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(m_handle, &size)) throw FileException("Ошибка получения размера файла.");
+            return static_cast<std::uint64_t>(size.QuadPart);
+        }
+
+        void ReadAt(std::uint64_t offset, void* data, std::size_t size) override
+        {
+            auto* p = static_cast<char*>(data);
+            while (size > 0)
+            {
+                OVERLAPPED ov = MakeOverlapped(offset);
+                DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size, 1u << 30));
+                DWORD got = 0;
+                if (!ReadFile(m_handle, p, chunk, &got, &ov) || got == 0)
+                    throw FileException("Ошибка чтения байтов из файла.");
+                p += got;
+                offset += got;
+                size -= got;
+            }
+        }
+
+        void WriteAt(std::uint64_t offset, const void* data, std::size_t size) override
+        {
+            auto* p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                OVERLAPPED ov = MakeOverlapped(offset);
+                DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size, 1u << 30));
+                DWORD put = 0;
+                if (!WriteFile(m_handle, p, chunk, &put, &ov) || put == 0)
+                    throw FileException("Ошибка записи байтов в файл.");
+                p += put;
+                offset += put;
+                size -= put;
+            }
+        }
+
+        // данные уже переданы ОС, как и после flush() у fstream
+        void Flush() override {}
+
+        // место выделяется без изменения конца файла
+        void Reserve(std::uint64_t size) override
+        {
+            FILE_ALLOCATION_INFO info{};
+            info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+            SetFileInformationByHandle(m_handle, FileAllocationInfo, &info, sizeof(info));
+        }
+
+        void Truncate(std::uint64_t size) override
+        {
+            FILE_END_OF_FILE_INFO info{};
+            info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+            if (!SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &info, sizeof(info)))
+                throw FileException("Ошибка изменения размера файла.");
+        }
+
+    private:
+        static OVERLAPPED MakeOverlapped(std::uint64_t offset)
+        {
+            OVERLAPPED ov{};
+            ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            return ov;
+        }
+
+        HANDLE m_handle = INVALID_HANDLE_VALUE;
+    };
+#else
+    class PositionalStorage final : public IStorage
+    {
+    public:
+        ~PositionalStorage() override { Close(); }
+
+        void Open(const std::string& path, bool truncate) override
+        {
+            Close();
+            const int flags = O_RDWR | (truncate ? (O_CREAT | O_TRUNC) : 0);
+            m_fd = ::open(path.c_str(), flags, 0644);
+            if (m_fd < 0)
+                throw FileException((truncate ? "Не удалось создать файл: " : "Не удалось открыть файл: ") + path);
+        }
+
+        void Close() override
+        {
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+                m_fd = -1;
+            }
+        }
+
+        bool IsOpen() const override { return m_fd >= 0; }
+
+        std::uint64_t Size() override
+        {
+            struct stat st {};
+            if (::fstat(m_fd, &st) != 0) throw FileException("Ошибка получения размера файла.");
+            return static_cast<std::uint64_t>(st.st_size);
+        }
+
+        void ReadAt(std::uint64_t offset, void* data, std::size_t size) override
+        {
+            auto* p = static_cast<char*>(data);
+            while (size > 0)
+            {
+                auto got = ::pread(m_fd, p, size, static_cast<off_t>(offset));
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) throw FileException("Ошибка чтения байтов из файла.");
+                p += got;
+                offset += static_cast<std::uint64_t>(got);
+                size -= static_cast<std::size_t>(got);
+            }
+        }
+
+        void WriteAt(std::uint64_t offset, const void* data, std::size_t size) override
+        {
+            auto* p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                auto put = ::pwrite(m_fd, p, size, static_cast<off_t>(offset));
+                if (put < 0 && errno == EINTR) continue;
+                if (put <= 0) throw FileException("Ошибка записи байтов в файл.");
+                p += put;
+                offset += static_cast<std::uint64_t>(put);
+                size -= static_cast<std::size_t>(put);
+            }
+        }
+
+        // данные уже переданы ОС, как и после flush() у fstream
+        void Flush() override {}
+
+        // Файл растёт до size нулями одним вызовом вместо увеличения на каждой записи.
+        // Ошибка не критична: запись за концом всё равно расширит файл.
+        void Reserve(std::uint64_t size) override
+        {
+            if (size <= Size()) return;
+  #if defined(__APPLE__)
+            ::ftruncate(m_fd, static_cast<off_t>(size));
+  #else
+            ::posix_fallocate(m_fd, 0, static_cast<off_t>(size));
+  #endif
+        }
+
+        void Truncate(std::uint64_t size) override
+        {
+            int rc;
+            do rc = ::ftruncate(m_fd, static_cast<off_t>(size));
+            while (rc != 0 && errno == EINTR);
+            if (rc != 0) throw FileException("Ошибка изменения размера файла.");
+        }
+
+    private:
+        int m_fd = -1;
+    };
+#endif
+
+    // ---- память ----
+
+    using MemoryBlob = std::shared_ptr<std::vector<std::uint8_t>>;
+
+    struct MemoryVolume
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, MemoryBlob> files;
+    };
+
+    static MemoryVolume& Volume()
+    {
+        static MemoryVolume volume;
+        return volume;
+    }
+
+    class MemoryStorage final : public IStorage
+    {
+    public:
+        void Open(const std::string& path, bool truncate) override
+        {
+            Close();
+
+            auto& volume = Volume();
+            std::lock_guard<std::mutex> lock(volume.mutex);
+
+            auto& blob = volume.files[path];
+            if (!blob)
+            {
+                blob = std::make_shared<std::vector<std::uint8_t>>();
+                if (!truncate && !LoadSnapshot(path, *blob))
+                {
+                    volume.files.erase(path);
+                    throw FileException("Не удалось открыть файл: " + path);
+                }
+            }
+            if (truncate) blob->clear();
+            m_blob = blob;
+        }
+
+        void Close() override { m_blob.reset(); }
+        bool IsOpen() const override { return m_blob != nullptr; }
+
+        std::uint64_t Size() override { return m_blob->size(); }
+
+        void ReadAt(std::uint64_t offset, void* data, std::size_t size) override
+        {
+            if (offset + size > m_blob->size()) throw FileException("Ошибка чтения байтов из файла.");
+            std::memcpy(data, m_blob->data() + offset, size);
+        }
+
+        void WriteAt(std::uint64_t offset, const void* data, std::size_t size) override
+        {
+            if (offset + size > m_blob->size()) m_blob->resize(static_cast<std::size_t>(offset + size));
+            std::memcpy(m_blob->data() + offset, data, size);
+        }
+
+        void Flush() override {}
+
+        void Reserve(std::uint64_t size) override { m_blob->reserve(static_cast<std::size_t>(size)); }
+        void Truncate(std::uint64_t size) override { m_blob->resize(static_cast<std::size_t>(size)); }
+
+    private:
+        static bool LoadSnapshot(const std::string& path, std::vector<std::uint8_t>& out)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) return false;
+            out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        MemoryBlob m_blob;
+    };
+
+    std::unique_ptr<IStorage> CreateStorage(StorageBackend backend)
+    {
+        switch (backend)
+        {
+        case StorageBackend::Posix: return std::make_unique<PositionalStorage>();
+        case StorageBackend::Memory: return std::make_unique<MemoryStorage>();
+        case StorageBackend::Fstream:
+        default: return std::make_unique<FstreamStorage>();
+        }
+    }
+
+    void RemoveStorageFile(StorageBackend backend, const std::string& path)
+    {
+        if (backend != StorageBackend::Memory)
+        {
+            if (std::remove(path.c_str()) != 0 && errno != ENOENT)
+                throw FileException("Не удалось удалить файл: " + path + " (" + std::strerror(errno) + ")");
+            return;
+        }
+
+        auto& volume = Volume();
+        std::lock_guard<std::mutex> lock(volume.mutex);
+        volume.files.erase(path);
+    }
+
+    void RenameStorageFile(StorageBackend backend, const std::string& from, const std::string& to)
+    {
+        if (backend != StorageBackend::Memory)
+        {
+            if (std::rename(from.c_str(), to.c_str()) != 0)
+                throw FileException("Не удалось переименовать файл " + from + " в " + to + " (" + std::strerror(errno) + ")");
+            return;
+        }
+
+        auto& volume = Volume();
+        std::lock_guard<std::mutex> lock(volume.mutex);
+        auto it = volume.files.find(from);
+        if (it == volume.files.end()) throw FileException("Не удалось переименовать файл " + from + ": его нет.");
+        auto blob = it->second;
+        volume.files.erase(it);
+        volume.files[to] = std::move(blob);
+    }
+}
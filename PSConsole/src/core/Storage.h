@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ps
+{
+    // Способ хранения файла за BinaryFile.
+    enum class StorageBackend : std::uint8_t
+    {
+        Fstream = 0, // std::fstream
+        Posix = 1,   // pread/pwrite по дескриптору (на Windows — ReadFile/WriteFile со смещением)
+        Memory = 2   // байты в памяти процесса, диск не изменяется
+    };
+
+    // позиционный ввод-вывод без курсора: одна системная операция на чтение/запись
+    constexpr StorageBackend DefaultStorageBackend = StorageBackend::Posix;
+
+    std::string ToString(StorageBackend backend);
+
+    // Хранилище байтов с позиционным доступом; позиции курсора у него нет.
+    // Ошибки ввода-вывода сообщаются FileException.
+    class IStorage
+    {
+    public:
+        virtual ~IStorage() = default;
+
+        // truncate = true: создать файл или обнулить существующий
+        virtual void Open(const std::string& path, bool truncate) = 0;
+        virtual void Close() = 0;
+        virtual bool IsOpen() const = 0;
+
+        virtual std::uint64_t Size() = 0;
+        virtual void ReadAt(std::uint64_t offset, void* data, std::size_t size) = 0;
+        virtual void WriteAt(std::uint64_t offset, const void* data, std::size_t size) = 0;
+        virtual void Flush() = 0;
+
+        // Заранее выделить место под size байт. Это подсказка: хранилище может
+        // увеличить физический размер (заполнив нулями) или ничего не делать.
+        virtual void Reserve(std::uint64_t size) = 0;
+        // Установить размер файла (используется для отрезания выделенного с запасом хвоста).
+        virtual void Truncate(std::uint64_t size) = 0;
+    };
+
+    std::unique_ptr<IStorage> CreateStorage(StorageBackend backend);
+
+    // Операции над файлами по имени в пространстве выбранного хранилища.
+    // Для Memory это "том" в памяти процесса: файл, открытый впервые, читается
+    // с диска как снимок, дальнейшие изменения остаются в памяти.
+    // Ошибка — FileException; удаление отсутствующего файла ошибкой не считается.
+    void RemoveStorageFile(StorageBackend backend, const std::string& path);
+    void RenameStorageFile(StorageBackend backend, const std::string& from, const std::string& to);
+}
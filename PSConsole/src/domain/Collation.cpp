@@ -0,0 +1,129 @@
+#include "Collation.h"
+#include <cstdint>
+
+namespace ps
+{
+    // Первичный вес — 24 бита; 0 зарезервирован под разделитель уровней ключа.
+    static constexpr std::uint32_t PunctBase = 0x000100;
+    static constexpr std::uint32_t DigitBase = 0x001000;
+    static constexpr std::uint32_t LatinBase = 0x002000;
+    static constexpr std::uint32_t CyrillicBase = 0x003000;
+    static constexpr std::uint32_t OtherBase = 0x100000;
+
+    static constexpr std::uint8_t Lower = 1; // и символы без регистра
+    static constexpr std::uint8_t Upper = 2;
+
+    static constexpr char32_t Invalid = 0xFFFD;
+
+    // Следующий символ UTF-8; некорректная последовательность даёт U+FFFD и один байт.
+    static char32_t NextCodePoint(std::string_view s, std::size_t& i)
+    {
+        const auto b0 = static_cast<unsigned char>(s[i++]);
+        if (b0 < 0x80) return b0;
+
+        int extra = 0;
+        char32_t cp = 0;
+        if ((b0 & 0xE0) == 0xC0) { extra = 1; cp = b0 & 0x1F; }
+        else if ((b0 & 0xF0) == 0xE0) { extra = 2; cp = b0 & 0x0F; }
+        else if ((b0 & 0xF8) == 0xF0) { extra = 3; cp = b0 & 0x07; }
+        else return Invalid;
+
+        if (i + extra > s.size()) return Invalid;
+        for (int k = 0; k < extra; k++)
+        {
+            const auto b = static_cast<unsigned char>(s[i + k]);
+            if ((b & 0xC0) != 0x80) return Invalid;
+            cp = (cp << 6) | (b & 0x3F);
+        }
+        i += extra;
+        return cp;
+    }
+
+    static void Weigh(char32_t cp, std::uint32_t& primary, std::uint8_t& tertiary)
+    {
+        tertiary = Lower;
+
+        if (cp >= '0' && cp <= '9') { primary = DigitBase + (cp - '0'); return; }
+        if (cp >= 'a' && cp <= 'z') { primary = LatinBase + (cp - 'a'); return; }
+        if (cp >= 'A' && cp <= 'Z') { primary = LatinBase + (cp - 'A'); tertiary = Upper; return; }
+        if (cp < 0x80) { primary = PunctBase + cp; return; }
+
+        // а..е = 0..5, ё = 6, ж..я = 7..32 (U+0430..U+044F, ё — U+0451; прописные — U+0410..U+042F, Ё — U+0401)
+        if (cp == 0x0451) { primary = CyrillicBase + 6; return; }
+        if (cp == 0x0401) { primary = CyrillicBase + 6; tertiary = Upper; return; }
+        if (cp >= 0x0430 && cp <= 0x044F)
+        {
+            const auto idx = cp - 0x0430;
+            primary = CyrillicBase + idx + (idx > 5 ? 1 : 0);
+            return;
+        }
+        if (cp >= 0x0410 && cp <= 0x042F)
+        {
+            const auto idx = cp - 0x0410;
+            primary = CyrillicBase + idx + (idx > 5 ? 1 : 0);
+            tertiary = Upper;
+            return;
+        }
+
+        primary = OtherBase + static_cast<std::uint32_t>(cp);
+    }
+
+    std::string CollationKey(std::string_view utf8)
+    {
+        std::string key;
+        std::string cases;
+        key.reserve(utf8.size() * 4 + 4);
+        cases.reserve(utf8.size());
+
+        for (std::size_t i = 0; i < utf8.size();)
+        {
+            std::uint32_t primary = 0;
+            std::uint8_t tertiary = Lower;
+            Weigh(NextCodePoint(utf8, i), primary, tertiary);
+
+            key.push_back(static_cast<char>(primary >> 16));
+            key.push_back(static_cast<char>(primary >> 8));
+            key.push_back(static_cast<char>(primary));
+            cases.push_back(static_cast<char>(tertiary));
+        }
+
+        // разделители меньше любого веса своего уровня: короткое имя идёт раньше своего продолжения
+        key.append(3, '\0');
+        key += cases;
+        key.push_back('\0');
+        key.append(utf8);
+        return key;
+    }
+
+    std::string CollationPrefix(std::string_view utf8)
+    {
+        std::string key;
+        key.reserve(utf8.size() * 3);
+        for (std::size_t i = 0; i < utf8.size();)
+        {
+            std::uint32_t primary = 0;
+            std::uint8_t tertiary = Lower;
+            Weigh(NextCodePoint(utf8, i), primary, tertiary);
+
+            key.push_back(static_cast<char>(primary >> 16));
+            key.push_back(static_cast<char>(primary >> 8));
+            key.push_back(static_cast<char>(primary));
+        }
+        return key;
+    }
+
+    std::u32string FoldCase(std::string_view utf8)
+    {
+        std::u32string out;
+        out.reserve(utf8.size());
+        for (std::size_t i = 0; i < utf8.size();)
+        {
+            auto cp = NextCodePoint(utf8, i);
+            if (cp >= 'A' && cp <= 'Z') cp += 'a' - 'A';
+            else if (cp >= 0x0410 && cp <= 0x042F) cp += 0x0430 - 0x0410;
+            else if (cp == 0x0401) cp = 0x0451;
+            out.push_back(cp);
+        }
+        return out;
+    }
+}
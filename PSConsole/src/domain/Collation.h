@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace ps
+{
+    // Двоичный ключ сортировки имени (UTF-8). Ключи сравниваются побайтно
+    // (memcmp / std::string::compare), и этот порядок — порядок имён для человека:
+    //  - сначала по буквам без учёта регистра: пробел и знаки, цифры, латиница,
+    //    кириллица в порядке русского алфавита (ё — между е и ж);
+    //  - при равенстве — строчная раньше прописной;
+    //  - при полном совпадении — по байтам имени (разные имена не дают равных ключей).
+    std::string CollationKey(std::string_view utf8);
+
+    // Начало ключа, общее для всех имён, которые начинаются с utf8 без учёта
+    // регистра (только первичные веса): такие имена идут в порядке ключей подряд.
+    std::string CollationPrefix(std::string_view utf8);
+
+    // Символы имени в нижнем регистре (латиница и русский алфавит, Ё -> ё) —
+    // форма для поиска без учёта регистра. Некорректный UTF-8 даёт U+FFFD.
+    std::u32string FoldCase(std::string_view utf8);
+}
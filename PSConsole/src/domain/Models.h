@@ -31,30 +31,78 @@ namespace ps
         return std::nullopt;
     }
 
+    // Номер записи в файле, начиная с 1; 0 — пустая ссылка.
+    // Позиция записи вычисляется по номеру, поэтому ссылки не зависят от смещений в файле.
+    using RecordId = std::uint64_t;
+    constexpr RecordId NullId = 0;
+
     struct ComponentRecord
     {
         bool deleted = false;
-        std::uint32_t firstSpecPtr = 1; // NULL = 1
-        std::uint32_t nextPtr = 1;
+        RecordId firstSpecId = NullId;
+        RecordId nextId = NullId;
         ComponentType type = ComponentType::Detail;
         std::string name;
-        std::uint32_t fileOffset = 0;
+        RecordId id = NullId;
+
+        // где лежит имя в куче имён (.prn)
+        std::uint64_t nameOffset = 0;
+        std::uint16_t nameLen = 0;
+
+        // активных записей спецификаций, ссылающихся на компонент
+        std::uint32_t refCount = 0;
+    };
+
+    // Условия отбора компонентов (команда Select); незаданное условие не проверяется.
+    struct ComponentQuery
+    {
+        std::optional<ComponentType> type;
+        std::optional<bool> deleted;
+        std::string name;        // образец имени; пустой — любое имя
+        bool namePrefix = false; // name — префикс ("Болт*"), иначе имя целиком
     };
 
     struct SpecRecord
     {
         bool deleted = false;
-        std::uint32_t componentPtr = 1;
+        RecordId componentId = NullId;
         std::uint16_t qty = 1;
-        std::uint32_t nextPtr = 1;
-        std::uint32_t fileOffset = 0;
+        RecordId nextId = NullId;
+        RecordId id = NullId;
     };
 
     struct ProductFileHeader
     {
         std::uint16_t dataLen = 0;
-        std::uint32_t headPtr = 1;
-        std::uint32_t freePtr = 0;
-        std::string specFileName; // 16 bytes fixed
+        std::uint16_t version = 0;
+        std::uint16_t flags = 0;
+        RecordId headId = NullId;
+        std::uint64_t recordCount = 0;
+        std::string specFileName;
+        std::uint64_t generation = 0; // растёт при каждом изменении .prd
+    };
+
+    struct SpecFileHeader
+    {
+        std::uint16_t version = 0;
+        std::uint16_t flags = 0;
+        RecordId headId = NullId;
+        std::uint64_t recordCount = 0;
+    };
+
+    struct NameHeapHeader
+    {
+        std::uint16_t version = 0;
+        std::uint16_t flags = 0;
+        std::uint64_t size = 0; // логический конец кучи
+    };
+
+    struct NameDictionaryHeader
+    {
+        std::uint16_t version = 0;
+        std::uint16_t flags = 0;
+        std::uint64_t generation = 0; // поколение .prd, по которому построен словарь
+        std::uint64_t count = 0;
+        std::uint64_t blockCount = 0;
     };
 }
@@ -1,4 +1,5 @@
 #include "Parsing.h"
+#include "../core/Errors.h"
 #include <cctype>
 
 namespace ps
@@ -67,20 +68,75 @@ namespace ps
             return cmd;
         }
 
-        // пробельные args
+        // Аргументы через пробел: как и в скобках, запятая разделяет аргументы,
+        // а кавычки снимаются и защищают пробелы и запятые внутри. Запятые во
+        // вложенных скобках (Create имя(20,prs)) остаются частью аргумента.
         std::vector<std::string> args;
         std::string cur;
+        bool inQuotes = false;
+        int depth = 0;
+        auto flush = [&]
+        {
+            if (!cur.empty()) args.push_back(cur);
+            cur.clear();
+        };
         for (char ch : rest)
         {
-            if (std::isspace(static_cast<unsigned char>(ch)))
+            if (ch == '"') { inQuotes = !inQuotes; continue; }
+            if (!inQuotes)
             {
-                if (!cur.empty()) { args.push_back(Trim(cur)); cur.clear(); }
-                continue;
+                if (ch == '(') depth++;
+                if (ch == ')' && depth > 0) depth--;
+                if (std::isspace(static_cast<unsigned char>(ch)) || (ch == ',' && depth == 0))
+                {
+                    flush();
+                    continue;
+                }
             }
             cur.push_back(ch);
         }
-        if (!cur.empty()) args.push_back(Trim(cur));
+        flush();
         cmd.args = args;
         return cmd;
     }
+
+    ComponentQuery ParseComponentQuery(const std::vector<std::string>& conditions)
+    {
+        ComponentQuery q;
+        for (const auto& cond : conditions)
+        {
+            const auto pos = cond.find_first_of("=~");
+            if (pos == std::string::npos) throw ValidationException("Условие без '=' или '~': " + cond + ".");
+
+            const auto field = Trim(cond.substr(0, pos));
+            const auto op = cond[pos];
+            const auto value = Trim(cond.substr(pos + 1));
+
+            if (field == "type" && op == '=')
+            {
+                q.type = ParseComponentType(value);
+                if (!q.type) throw ValidationException("Неизвестный тип компонента: " + value + ".");
+            }
+            else if (field == "deleted" && op == '=')
+            {
+                if (value != "0" && value != "1") throw ValidationException("deleted: ожидается 0 или 1.");
+                q.deleted = (value == "1");
+            }
+            else if (field == "name")
+            {
+                // name~ допускает '*' только в конце: отбор идёт по началу имени
+                const bool prefix = op == '~' && !value.empty() && value.back() == '*';
+                q.name = prefix ? value.substr(0, value.size() - 1) : value;
+                q.namePrefix = prefix;
+                if (q.name.find('*') != std::string::npos)
+                    throw ValidationException("Шаблон имени: поддерживается только '*' в конце.");
+                if (!prefix && q.name.empty()) throw ValidationException("Пустое имя в условии.");
+            }
+            else
+            {
+                throw ValidationException("Неизвестное условие: " + cond + ".");
+            }
+        }
+        return q;
+    }
 }
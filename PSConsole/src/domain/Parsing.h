@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "Models.h"
 
 namespace ps
 {
@@ -14,4 +15,8 @@ namespace ps
     ParsedCommand ParseCommandLine(const std::string& line);
     std::string StripOuterParens(const std::string& s);
     std::vector<std::string> SplitCsvArgs(const std::string& s);
+
+    // Условия вида type=Узел, deleted=0, name=Болт, name~Болт* (кавычки уже сняты SplitCsvArgs).
+    // Ошибка в условии — ValidationException.
+    ComponentQuery ParseComponentQuery(const std::vector<std::string>& conditions);
 }
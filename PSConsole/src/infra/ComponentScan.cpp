@@ -0,0 +1,108 @@
+#include "ComponentScan.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define PS_SCAN_SSE2 1
+  #include <emmintrin.h>
+#endif
+
+namespace ps
+{
+    static constexpr std::uint32_t DeletedBits = 0x000000FF;
+    static constexpr std::uint32_t TypeBits = 0x0000FF00;
+
+    // del(1) type(1) nameLen(2), порядок байт файла — little-endian
+    static std::uint32_t HeadWord(const std::uint8_t* rec)
+    {
+        return static_cast<std::uint32_t>(rec[0]) | static_cast<std::uint32_t>(rec[1]) << 8
+            | static_cast<std::uint32_t>(rec[2]) << 16 | static_cast<std::uint32_t>(rec[3]) << 24;
+    }
+
+    ComponentScan::ComponentScan(const ComponentQuery& query)
+    {
+        if (query.type)
+        {
+            m_mask |= TypeBits;
+            m_want |= static_cast<std::uint32_t>(*query.type) << 8;
+        }
+
+        // удалённая запись — любой ненулевой байт del, поэтому "удалена" проверяется отдельно
+        if (query.deleted)
+        {
+            if (*query.deleted) m_requireDeleted = true;
+            else m_mask |= DeletedBits;
+        }
+
+        // длина имени отсекает записи ещё до чтения кучи имён
+        m_name = query.name;
+        if (!m_name.empty())
+        {
+            m_minLen = static_cast<std::uint32_t>(m_name.size());
+            if (!query.namePrefix) m_maxLen = m_minLen;
+        }
+    }
+
+    bool ComponentScan::Matches(std::uint32_t word) const
+    {
+        const auto len = word >> 16;
+        return (word & m_mask) == m_want
+            && (!m_requireDeleted || (word & DeletedBits) != 0)
+            && len >= m_minLen && len <= m_maxLen;
+    }
+
+    void ComponentScan::FilterBlock(const std::uint8_t* records, std::size_t count, std::size_t recordSize, RecordId firstId,
+                                    std::vector<RecordId>& out) const
+    {
+        std::uint32_t words[BlockRecords];
+        for (std::size_t i = 0; i < count; i++) words[i] = HeadWord(records + i * recordSize);
+
+        std::size_t i = 0;
+#if defined(PS_SCAN_SSE2)
+        // длина сравнивается знаково: после сдвига на 16 она не больше 0xFFFF
+        const auto mask = _mm_set1_epi32(static_cast<int>(m_mask));
+        const auto want = _mm_set1_epi32(static_cast<int>(m_want));
+        const auto delBits = _mm_set1_epi32(static_cast<int>(DeletedBits));
+        const auto zero = _mm_setzero_si128();
+        const auto minLen = _mm_set1_epi32(static_cast<int>(m_minLen) - 1);
+        const auto maxLen = _mm_set1_epi32(static_cast<int>(m_maxLen) + 1);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+            auto ok = _mm_cmpeq_epi32(_mm_and_si128(v, mask), want);
+            if (m_requireDeleted)
+                ok = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(v, delBits), zero), ok);
+
+            const auto len = _mm_srli_epi32(v, 16);
+            ok = _mm_and_si128(ok, _mm_cmpgt_epi32(len, minLen));
+            ok = _mm_and_si128(ok, _mm_cmplt_epi32(len, maxLen));
+
+            const auto bits = _mm_movemask_ps(_mm_castsi128_ps(ok));
+            if (bits == 0) continue;
+            for (std::size_t k = 0; k < 4; k++)
+                if (bits & (1 << k)) out.push_back(firstId + i + k);
+        }
+#endif
+        for (; i < count; i++)
+            if (Matches(words[i])) out.push_back(firstId + i);
+    }
+
+    std::size_t ComponentScan::NameBytes() const { return m_name.size(); }
+
+    bool ComponentScan::MatchName(const std::uint8_t* name) const
+    {
+        const auto* want = reinterpret_cast<const std::uint8_t*>(m_name.data());
+        const auto n = m_name.size();
+
+        std::size_t i = 0;
+#if defined(PS_SCAN_SSE2)
+        for (; i + 16 <= n; i += 16)
+        {
+            const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(name + i));
+            const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(want + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return false;
+        }
+#endif
+        return std::memcmp(name + i, want + i, n - i) == 0;
+    }
+}
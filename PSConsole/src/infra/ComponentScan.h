@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Отбор записей .prd по сырым байтам, без декодирования в ComponentRecord.
+    //
+    // Первые четыре байта записи — del(1) type(1) nameLen(2) (см. ComponentLayout).
+    // Условия на тип, признак удаления и длину имени сводятся к маске и сравнению
+    // этого слова; блок записей проверяется по четыре слова за операцию SSE2
+    // (без SSE2 — тот же отбор по одному слову). Имя затем сверяется только у
+    // прошедших записей и только в объёме образца.
+    class ComponentScan final
+    {
+    public:
+        static constexpr std::size_t BlockRecords = 256; // записей за одно чтение
+
+        explicit ComponentScan(const ComponentQuery& query);
+
+        // Номера записей блока (первая — firstId), прошедших условия на байты записи.
+        // count <= BlockRecords; out дополняется, не очищается.
+        void FilterBlock(const std::uint8_t* records, std::size_t count, std::size_t recordSize, RecordId firstId,
+                         std::vector<RecordId>& out) const;
+
+        // сколько первых байт имени нужно MatchName (0 — имя не проверяется)
+        std::size_t NameBytes() const;
+        bool MatchName(const std::uint8_t* name) const;
+
+    private:
+        std::uint32_t m_mask = 0;   // проверяемые биты слова
+        std::uint32_t m_want = 0;   // их ожидаемое значение
+        bool m_requireDeleted = false;
+        std::uint32_t m_minLen = 0;
+        std::uint32_t m_maxLen = UINT16_MAX;
+        std::string m_name;
+
+        bool Matches(std::uint32_t word) const;
+    };
+}
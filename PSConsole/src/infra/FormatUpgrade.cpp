@@ -0,0 +1,124 @@
+#include "FormatUpgrade.h"
+#include "LegacyFormat.h"
+#include "ProductFile.h"
+#include "RecordFile.h"
+#include "RecordLayout.h"
+
+namespace ps
+{
+    static std::string TrimSpaces(const std::string& s)
+    {
+        auto b = s.find_first_not_of(' ');
+        if (b == std::string::npos) return "";
+        auto e = s.find_last_not_of(' ');
+        return s.substr(b, e - b + 1);
+    }
+
+    static bool IsLegacyProductFile(const std::string& prdPath, StorageBackend backend)
+    {
+        BinaryFile f;
+        f.OpenRW(prdPath, backend);
+        std::uint8_t magic[ProductSignature::size] = {};
+        if (f.Size() < sizeof(magic)) return false;
+
+        f.ReadAt(0, magic, sizeof(magic));
+        if (ProductSignature::Matches(magic)) return false;
+        return v1::ProductSignature::Matches(magic);
+    }
+
+    // Смещение v1 -> номер записи. Ссылка не на начало записи означает повреждённый файл.
+    template<typename File>
+    static RecordId PtrToId(std::uint32_t ptr, const File& file)
+    {
+        if (ptr == v1::NullPtr) return NullId;
+
+        const auto headerSize = file.HeaderSize();
+        const auto recordSize = file.RecordSize();
+        if (ptr < headerSize || (ptr - headerSize) % recordSize != 0 || (ptr - headerSize) / recordSize >= file.RecordCount())
+            throw FileException("Файл формата v1 повреждён: ссылка " + std::to_string(ptr) + " не указывает на запись.");
+
+        return (ptr - headerSize) / recordSize + 1;
+    }
+
+    bool UpgradeLegacyCatalog(const std::string& prdPath, const std::string& defaultPrsPath, StorageBackend backend)
+    {
+        if (!IsLegacyProductFile(prdPath, backend)) return false;
+
+        RecordFile<v1::ComponentFileLayout> oldPrd;
+        oldPrd.Open(prdPath, backend);
+
+        auto prsPath = TrimSpaces(oldPrd.GetHeader().specFileName);
+        if (prsPath.empty()) prsPath = defaultPrsPath;
+
+        RecordFile<v1::SpecFileLayout> oldPrs;
+        oldPrs.Open(prsPath, backend);
+
+        const auto prdTmp = prdPath + ".tmp";
+        const auto prsTmp = prsPath + ".tmp";
+
+        {
+            ProductFile newPrd;
+            newPrd.Create(prdTmp, static_cast<std::uint16_t>(oldPrd.GetHeader().dataLen - 1), prsPath, backend);
+
+            // в v1 счётчиков ссылок не было: они считаются по активным записям .prs
+            std::vector<std::uint32_t> refCounts(oldPrd.RecordCount());
+            for (const auto& old : oldPrs.Records())
+                if (!old.deleted && old.componentPtr != v1::NullPtr) refCounts[PtrToId(old.componentPtr, oldPrd) - 1]++;
+
+            ComponentRecord rec;
+            for (const auto& old : oldPrd.Records())
+            {
+                rec.deleted = old.deleted;
+                rec.type = old.type;
+                rec.name = old.name;
+                rec.firstSpecId = PtrToId(old.firstSpecPtr, oldPrs);
+                rec.nextId = PtrToId(old.nextPtr, oldPrd);
+                rec.refCount = refCounts[old.id - 1];
+                newPrd.AppendRecord(rec);
+            }
+            // v1 упорядочивал список по байтам имени, текущий формат — по ключам сортировки
+            newPrd.RebuildAlphabeticalLinks();
+            newPrd.Close();
+        }
+
+        {
+            SpecFileHeader header;
+            header.version = FormatVersion;
+            header.headId = PtrToId(oldPrs.GetHeader().headPtr, oldPrs);
+
+            RecordFile<SpecFileLayout> newPrs;
+            newPrs.Create(prsTmp, header, backend);
+
+            SpecRecord rec;
+            for (const auto& old : oldPrs.Records())
+            {
+                rec.deleted = old.deleted;
+                rec.qty = old.qty;
+                rec.componentId = PtrToId(old.componentPtr, oldPrd);
+                rec.nextId = PtrToId(old.nextPtr, oldPrs);
+                newPrs.AppendRecord(rec);
+            }
+            newPrs.Close();
+        }
+
+        oldPrd.Close();
+        oldPrs.Close();
+
+        for (const auto& [path, tmp] : { std::pair{ prdPath, prdTmp }, std::pair{ prsPath, prsTmp } })
+        {
+            RemoveStorageFile(backend, path + ".v1");
+            RenameStorageFile(backend, path, path + ".v1");
+            RenameStorageFile(backend, tmp, path);
+        }
+
+        // у v1 не было ни кучи имён, ни словаря: на месте может остаться только чужой файл
+        const auto sidecars = ProductFile::SidecarPathsFor(prdPath);
+        const auto sidecarsTmp = ProductFile::SidecarPathsFor(prdTmp);
+        for (std::size_t i = 0; i < sidecars.size(); i++)
+        {
+            RemoveStorageFile(backend, sidecars[i]);
+            RenameStorageFile(backend, sidecarsTmp[i], sidecars[i]);
+        }
+        return true;
+    }
+}
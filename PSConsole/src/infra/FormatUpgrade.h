@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include "../core/Storage.h"
+
+namespace ps
+{
+    // Обновление каталога формата v1 (см. LegacyFormat.h) до текущего формата.
+    // Ссылки-смещения v1 пересчитываются в номера записей; порядок записей,
+    // включая удалённые, сохраняется, поэтому Restore работает как прежде.
+    // Новые файлы (.prd, .prs, куча имён .prn, словарь .pnd) пишутся во временные и подменяют
+    // исходные, а исходные остаются рядом с суффиксом ".v1".
+    //
+    // Возвращает false, если .prd уже в текущем формате или вовсе не похож на
+    // каталог (об этом сообщит обычное открытие). defaultPrsPath используется,
+    // если имя .prs в заголовке v1 пустое.
+    bool UpgradeLegacyCatalog(const std::string& prdPath, const std::string& defaultPrsPath, StorageBackend backend);
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "RecordLayout.h"
+
+namespace ps
+{
+    // Формат v1 (до версионирования): 32-битные ссылки — смещения в байтах от
+    // начала файла, пустая ссылка = 1, у .prs нет ни сигнатуры, ни версии.
+    // Используется только для чтения при обновлении каталога до текущего формата
+    // (см. FormatUpgrade.h); записи декодируются "как есть", без пересчёта ссылок.
+    namespace v1
+    {
+        constexpr std::uint32_t NullPtr = 1;
+
+        // Имя в поле фиксированной ширины, дополненное пробелами. Копируется уже
+        // обрезанным в буфер записи: при обходе курсором память не выделяется.
+        inline void DecodePaddedName(const std::uint8_t* field, std::size_t width, std::string& out)
+        {
+            const char* name = reinterpret_cast<const char*>(field);
+            std::size_t b = 0;
+            std::size_t e = width;
+            while (b < e && name[b] == ' ') b++;
+            while (e > b && name[e - 1] == ' ') e--;
+            out.assign(name + b, e - b);
+        }
+
+        inline void EncodePaddedName(const std::string& name, std::size_t width, std::uint8_t* field)
+        {
+            const auto len = std::min(name.size(), width);
+            std::memcpy(field, name.data(), len);
+            std::memset(field + len, ' ', width - len);
+        }
+
+        struct ComponentRecord
+        {
+            bool deleted = false;
+            std::uint32_t firstSpecPtr = NullPtr;
+            std::uint32_t nextPtr = NullPtr;
+            ComponentType type = ComponentType::Detail;
+            std::string name;
+            RecordId id = NullId;
+        };
+
+        struct SpecRecord
+        {
+            bool deleted = false;
+            std::uint32_t componentPtr = NullPtr;
+            std::uint16_t qty = 1;
+            std::uint32_t nextPtr = NullPtr;
+            RecordId id = NullId;
+        };
+
+        struct ProductFileHeader
+        {
+            std::uint16_t dataLen = 0;
+            std::uint32_t headPtr = NullPtr;
+            std::uint32_t freePtr = 0;
+            std::string specFileName;
+        };
+
+        struct SpecFileHeader
+        {
+            std::uint32_t headPtr = NullPtr;
+            std::uint32_t freePtr = 0;
+        };
+
+        // .prd: del(1) firstSpecPtr(4) nextPtr(4) type(1), далее имя шириной maxNameLen
+        using ComponentLayout = RecordLayout<ComponentRecord,
+            Field<&ComponentRecord::deleted, 0, std::uint8_t>,
+            Field<&ComponentRecord::firstSpecPtr, 1, std::uint32_t>,
+            Field<&ComponentRecord::nextPtr, 5, std::uint32_t>,
+            Field<&ComponentRecord::type, 9, std::uint8_t>>;
+
+        // .prs: del(1) componentPtr(4) qty(2) nextPtr(4)
+        using SpecLayout = RecordLayout<SpecRecord,
+            Field<&SpecRecord::deleted, 0, std::uint8_t>,
+            Field<&SpecRecord::componentPtr, 1, std::uint32_t>,
+            Field<&SpecRecord::qty, 5, std::uint16_t>,
+            Field<&SpecRecord::nextPtr, 7, std::uint32_t>>;
+
+        using ProductSignature = SignatureField<0, 'P', 'S'>;
+
+        // .prd: 'PS'(2) dataLen(2) headPtr(4) freePtr(4) имя .prs(16)
+        using ProductHeaderLayout = RecordLayout<ProductFileHeader,
+            ProductSignature,
+            Field<&ProductFileHeader::dataLen, 2, std::uint16_t>,
+            Field<&ProductFileHeader::headPtr, 4, std::uint32_t>,
+            Field<&ProductFileHeader::freePtr, 8, std::uint32_t>,
+            FixedStringField<&ProductFileHeader::specFileName, 12, 16>>;
+
+        // .prs: headPtr(4) freePtr(4)
+        using SpecHeaderLayout = RecordLayout<SpecFileHeader,
+            Field<&SpecFileHeader::headPtr, 0, std::uint32_t>,
+            Field<&SpecFileHeader::freePtr, 4, std::uint32_t>>;
+
+        // Логический конец v1 — freePtr. Если он не указывает за заголовок,
+        // берётся физический размер (RecordFile ограничивает число записей им).
+        inline std::uint64_t CountFromFreePtr(std::uint32_t freePtr, std::size_t headerSize, std::size_t recordSize)
+        {
+            if (freePtr < headerSize) return ~0ull;
+            return (freePtr - headerSize) / recordSize;
+        }
+
+        struct ComponentFileLayout
+        {
+            using Record = ComponentRecord;
+            using Header = ProductFileHeader;
+
+            static constexpr std::size_t HeaderSize = ProductHeaderLayout::FixedSize;
+
+            static std::size_t RecordSize(const Header& h) { return ComponentLayout::FixedSize + (h.dataLen - 1u); }
+
+            static std::uint64_t RecordCount(const Header& h) { return CountFromFreePtr(h.freePtr, HeaderSize, RecordSize(h)); }
+            static void SetRecordCount(Header& h, std::uint64_t count)
+            {
+                h.freePtr = static_cast<std::uint32_t>(HeaderSize + count * RecordSize(h));
+            }
+
+            static void DecodeHeader(const std::uint8_t* block, Header& h)
+            {
+                if (!ProductSignature::Matches(block))
+                    throw FileException("Сигнатура файла отсутствует или неверна (ожидалось 'PS').");
+
+                ProductHeaderLayout::Decode(block, h);
+                if (h.dataLen < 2)
+                    throw FileException("Некорректная длина области данных (dataLen) в заголовке.");
+            }
+
+            static void EncodeHeader(const Header& h, std::uint8_t* block) { ProductHeaderLayout::Encode(h, block); }
+
+            static void DecodeRecord(const std::uint8_t* block, const Header& h, Record& rec)
+            {
+                ComponentLayout::Decode(block, rec);
+                DecodePaddedName(block + ComponentLayout::FixedSize, h.dataLen - 1u, rec.name);
+            }
+
+            static void EncodeRecord(const Record& rec, const Header& h, std::uint8_t* block)
+            {
+                ComponentLayout::Encode(rec, block);
+                EncodePaddedName(rec.name, h.dataLen - 1u, block + ComponentLayout::FixedSize);
+            }
+        };
+
+        struct SpecFileLayout
+        {
+            using Record = SpecRecord;
+            using Header = SpecFileHeader;
+
+            static constexpr std::size_t HeaderSize = SpecHeaderLayout::FixedSize;
+
+            static std::size_t RecordSize(const Header&) { return SpecLayout::FixedSize; }
+
+            static std::uint64_t RecordCount(const Header& h) { return CountFromFreePtr(h.freePtr, HeaderSize, SpecLayout::FixedSize); }
+            static void SetRecordCount(Header& h, std::uint64_t count)
+            {
+                h.freePtr = static_cast<std::uint32_t>(HeaderSize + count * SpecLayout::FixedSize);
+            }
+
+            static void DecodeHeader(const std::uint8_t* block, Header& h) { SpecHeaderLayout::Decode(block, h); }
+            static void EncodeHeader(const Header& h, std::uint8_t* block) { SpecHeaderLayout::Encode(h, block); }
+
+            static void DecodeRecord(const std::uint8_t* block, const Header&, Record& rec) { SpecLayout::Decode(block, rec); }
+            static void EncodeRecord(const Record& rec, const Header&, std::uint8_t* block) { SpecLayout::Encode(rec, block); }
+        };
+    }
+}
@@ -0,0 +1,417 @@
+#include "NameDictionary.h"
+#include "../core/BinaryIO.h"
+#include "../domain/Collation.h"
+#include "RecordLayout.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ps
+{
+    static constexpr std::size_t HeaderSize = NameDictionaryHeaderLayout::FixedSize;
+
+    // ---- varint (LEB128) ----
+
+    static void PutVarint(std::vector<std::uint8_t>& out, std::uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    static std::uint64_t GetVarint(const std::uint8_t*& p, const std::uint8_t* end)
+    {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (p == end) throw FileException("Словарь имён повреждён.");
+            const auto b = *p++;
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        throw FileException("Словарь имён повреждён.");
+    }
+
+    static std::string_view GetBytes(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t len)
+    {
+        if (len > static_cast<std::uint64_t>(end - p)) throw FileException("Словарь имён повреждён.");
+        std::string_view s(reinterpret_cast<const char*>(p), static_cast<std::size_t>(len));
+        p += len;
+        return s;
+    }
+
+    static bool StartsWith(std::string_view s, std::string_view prefix)
+    {
+        return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    std::string NameDictionary::PathFor(const std::string& prdPath)
+    {
+        const std::string ext = ".prd";
+        if (prdPath.size() >= ext.size() && prdPath.compare(prdPath.size() - ext.size(), ext.size(), ext) == 0)
+            return prdPath.substr(0, prdPath.size() - ext.size()) + ".pnd";
+        return prdPath + ".pnd";
+    }
+
+    // ---- обход основы по порядку ----
+
+    class NameDictionary::Cursor final
+    {
+    public:
+        explicit Cursor(const NameDictionary& dict) : m_dict(dict) {}
+
+        bool Valid() const { return m_valid; }
+        const std::string& Name() const { return m_name; }
+        // ключ сортировки имени; считается при первом обращении на этой позиции
+        const std::string& SortKey()
+        {
+            if (!m_sortKeyReady) m_sortKey = CollationKey(m_name);
+            m_sortKeyReady = true;
+            return m_sortKey;
+        }
+        RecordId Id() const { return m_id; }
+        std::uint32_t Duplicates() const { return m_duplicates; }
+
+        void SeekBlock(std::uint64_t block)
+        {
+            m_valid = block < m_dict.m_blockCount;
+            if (!m_valid) return;
+
+            m_block = block;
+            m_p = m_dict.m_data.data() + BlockOffset(block);
+            m_end = block + 1 < m_dict.m_blockCount
+                ? m_dict.m_data.data() + BlockOffset(block + 1)
+                : m_dict.m_data.data() + m_dict.m_data.size();
+
+            const auto len = GetVarint(m_p, m_end);
+            m_name.assign(GetBytes(m_p, m_end, len));
+            ReadValue();
+        }
+
+        void Next()
+        {
+            if (m_p == m_end)
+            {
+                SeekBlock(m_block + 1);
+                return;
+            }
+
+            const auto shared = GetVarint(m_p, m_end);
+            const auto suffixLen = GetVarint(m_p, m_end);
+            if (shared > m_name.size()) throw FileException("Словарь имён повреждён.");
+            m_name.resize(static_cast<std::size_t>(shared));
+            m_name.append(GetBytes(m_p, m_end, suffixLen));
+            ReadValue();
+        }
+
+        // первое имя, ключ сортировки которого >= key
+        void LowerBound(std::string_view key)
+        {
+            SeekBlock(m_dict.FindBlock(key));
+            while (m_valid && std::string_view(SortKey()) < key) Next();
+        }
+
+        std::uint64_t BlockOffset(std::uint64_t block) const
+        {
+            std::uint64_t off = 0;
+            std::memcpy(&off, m_dict.m_data.data() + HeaderSize + block * sizeof(off), sizeof(off));
+            return off;
+        }
+
+    private:
+        void ReadValue()
+        {
+            m_sortKeyReady = false;
+            m_id = GetVarint(m_p, m_end);
+            const auto duplicates = GetVarint(m_p, m_end);
+            if (duplicates > UINT32_MAX) throw FileException("Словарь имён повреждён.");
+            m_duplicates = static_cast<std::uint32_t>(duplicates);
+        }
+
+        const NameDictionary& m_dict;
+        std::uint64_t m_block = 0;
+        const std::uint8_t* m_p = nullptr;
+        const std::uint8_t* m_end = nullptr;
+        std::string m_name;
+        std::string m_sortKey;
+        bool m_sortKeyReady = false;
+        RecordId m_id = NullId;
+        std::uint32_t m_duplicates = 0;
+        bool m_valid = false;
+    };
+
+    std::string_view NameDictionary::BlockHead(std::uint64_t block) const
+    {
+        const auto* p = m_data.data() + Cursor(*this).BlockOffset(block);
+        const auto* end = m_data.data() + m_data.size();
+        const auto len = GetVarint(p, end);
+        return GetBytes(p, end, len);
+    }
+
+    // последний блок, ключ первого имени которого <= key (или 0)
+    std::uint64_t NameDictionary::FindBlock(std::string_view key) const
+    {
+        std::uint64_t lo = 0;
+        std::uint64_t hi = m_blockCount;
+        while (hi - lo > 1)
+        {
+            const auto mid = lo + (hi - lo) / 2;
+            if (CollationKey(BlockHead(mid)) <= key) lo = mid;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // ---- построение ----
+
+    void NameDictionary::Encode(const std::vector<Entry>& sorted, std::uint64_t generation)
+    {
+        NameDictionaryHeader header;
+        header.version = FormatVersion;
+        header.flags = DictionaryFlags;
+        header.generation = generation;
+        header.count = sorted.size();
+        header.blockCount = (sorted.size() + BlockSize - 1) / BlockSize;
+
+        std::vector<std::uint8_t> data(HeaderSize + header.blockCount * sizeof(std::uint64_t));
+        NameDictionaryHeaderLayout::Encode(header, data.data());
+
+        for (std::size_t i = 0; i < sorted.size(); i++)
+        {
+            const auto& name = sorted[i].name;
+            if (i % BlockSize == 0)
+            {
+                const std::uint64_t off = data.size();
+                std::memcpy(data.data() + HeaderSize + (i / BlockSize) * sizeof(off), &off, sizeof(off));
+
+                PutVarint(data, name.size());
+                data.insert(data.end(), name.begin(), name.end());
+            }
+            else
+            {
+                const auto& prev = sorted[i - 1].name;
+                const auto shared = std::mismatch(prev.begin(), prev.end(), name.begin(), name.end()).first - prev.begin();
+                PutVarint(data, static_cast<std::uint64_t>(shared));
+                PutVarint(data, name.size() - shared);
+                data.insert(data.end(), name.begin() + shared, name.end());
+            }
+            PutVarint(data, sorted[i].id);
+            PutVarint(data, sorted[i].duplicates);
+        }
+
+        m_data = std::move(data);
+        m_count = header.count;
+        m_blockCount = header.blockCount;
+    }
+
+    void NameDictionary::Assign(std::vector<Entry> entries)
+    {
+        // ключ считается один раз на имя; разные имена не дают равных ключей
+        std::vector<std::pair<std::string, Entry>> keyed;
+        keyed.reserve(entries.size());
+        for (auto& e : entries) keyed.emplace_back(CollationKey(e.name), std::move(e));
+        std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b)
+        {
+            return a.first != b.first ? a.first < b.first : a.second.id < b.second.id;
+        });
+
+        entries.clear();
+        for (std::size_t i = 0; i < keyed.size(); i++)
+        {
+            if (i > 0 && keyed[i - 1].first == keyed[i].first)
+            {
+                entries.back().duplicates += 1 + keyed[i].second.duplicates;
+                continue;
+            }
+            entries.push_back(std::move(keyed[i].second));
+        }
+
+        Encode(entries, 0);
+        m_added.clear();
+        m_removed.clear();
+        m_dirty = true;
+        m_savedGeneration.reset();
+    }
+
+    bool NameDictionary::Load(const std::string& path, StorageBackend backend, std::uint64_t generation)
+    {
+        std::vector<std::uint8_t> data;
+        try
+        {
+            BinaryFile f;
+            f.OpenRW(path, backend);
+            data.resize(static_cast<std::size_t>(f.Size()));
+            if (data.size() < HeaderSize) return false;
+            f.ReadAt(0, data.data(), data.size());
+        }
+        catch (const FileException&)
+        {
+            return false;
+        }
+
+        NameDictionaryHeader header;
+        if (!NameDictionarySignature::Matches(data.data())) return false;
+        NameDictionaryHeaderLayout::Decode(data.data(), header);
+        if (header.version != FormatVersion || header.flags != DictionaryFlags) return false;
+        if (header.generation != generation) return false;
+        if (header.blockCount != (header.count + BlockSize - 1) / BlockSize) return false;
+        if (header.blockCount > (data.size() - HeaderSize) / sizeof(std::uint64_t)) return false;
+
+        m_data = std::move(data);
+        m_count = header.count;
+        m_blockCount = header.blockCount;
+        m_added.clear();
+        m_removed.clear();
+        m_dirty = false;
+        m_savedGeneration = generation;
+
+        // один проход по всем блокам: смещения, порядок блоков и число записей
+        // (ключи считаются только для первых имён блоков — по ним идёт поиск)
+        try
+        {
+            Cursor c(*this);
+            const auto dataStart = HeaderSize + m_blockCount * sizeof(std::uint64_t);
+            for (std::uint64_t b = 0; b < m_blockCount; b++)
+            {
+                const auto off = c.BlockOffset(b);
+                const auto next = b + 1 < m_blockCount ? c.BlockOffset(b + 1) : m_data.size();
+                if (off < dataStart || off >= next || next > m_data.size()) throw FileException("Словарь имён повреждён.");
+            }
+
+            std::string prevHead;
+            for (std::uint64_t b = 0; b < m_blockCount; b++)
+            {
+                auto head = CollationKey(BlockHead(b));
+                if (b > 0 && !(prevHead < head)) throw FileException("Словарь имён повреждён.");
+                prevHead = std::move(head);
+            }
+
+            std::uint64_t n = 0;
+            for (c.SeekBlock(0); c.Valid(); c.Next()) n++;
+            if (n != m_count) throw FileException("Словарь имён повреждён.");
+        }
+        catch (const FileException&)
+        {
+            Encode({}, 0);
+            m_savedGeneration.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void NameDictionary::Save(const std::string& path, StorageBackend backend, std::uint64_t generation)
+    {
+        if (!m_dirty && m_savedGeneration)
+        {
+            // имена те же, что в файле: меняется только поколение в заголовке
+            NameDictionaryHeader header;
+            NameDictionaryHeaderLayout::Decode(m_data.data(), header);
+            header.generation = generation;
+            NameDictionaryHeaderLayout::Encode(header, m_data.data());
+
+            try
+            {
+                BinaryFile f;
+                f.OpenRW(path, backend);
+                f.WriteAt(0, m_data.data(), HeaderSize);
+                f.Close();
+                m_savedGeneration = generation;
+                return;
+            }
+            catch (const FileException&)
+            {
+                // файла уже нет — записать целиком
+            }
+        }
+
+        auto entries = WithPrefix("");
+        Encode(entries, generation);
+        m_added.clear();
+        m_removed.clear();
+
+        BinaryFile f;
+        f.CreateRWTruncate(path, backend);
+        f.WriteAt(0, m_data.data(), m_data.size());
+        f.Close();
+        m_dirty = false;
+        m_savedGeneration = generation;
+    }
+
+    bool NameDictionary::SavedFor(std::uint64_t generation) const { return !m_dirty && m_savedGeneration == generation; }
+
+    // ---- поиск и изменения ----
+
+    std::optional<RecordId> NameDictionary::Find(std::string_view name) const
+    {
+        const auto e = Lookup(name);
+        if (!e) return std::nullopt;
+        return e->id;
+    }
+
+    std::optional<NameDictionary::Entry> NameDictionary::Lookup(std::string_view name) const
+    {
+        const auto key = CollationKey(name);
+        if (auto it = m_added.find(key); it != m_added.end()) return it->second;
+        if (m_removed.find(name) != m_removed.end()) return std::nullopt;
+
+        Cursor c(*this);
+        c.LowerBound(key);
+        if (c.Valid() && c.Name() == name) return Entry{ c.Name(), c.Id(), c.Duplicates() };
+        return std::nullopt;
+    }
+
+    void NameDictionary::Insert(const std::string& name, RecordId id, std::uint32_t duplicates)
+    {
+        m_added[CollationKey(name)] = Entry{ name, id, duplicates };
+        m_dirty = true;
+    }
+
+    void NameDictionary::Erase(const std::string& name)
+    {
+        m_added.erase(CollationKey(name));
+        m_removed.insert(name);
+        m_dirty = true;
+    }
+
+    std::vector<NameDictionary::Entry> NameDictionary::WithPrefix(std::string_view prefix, std::size_t limit) const
+    {
+        std::vector<Entry> out;
+
+        // имена с таким началом без учёта регистра идут в порядке ключей подряд;
+        // при пустом начале (все имена) ключи основы нужны только для слияния с наложением
+        const auto key = CollationPrefix(prefix);
+        Cursor base(*this);
+        base.LowerBound(key);
+        auto added = m_added.lower_bound(key);
+
+        auto inBase = [&] { return base.Valid() && (key.empty() || StartsWith(base.SortKey(), key)); };
+        auto replaced = [&]
+        {
+            return m_removed.count(base.Name()) != 0 || (!m_added.empty() && m_added.count(base.SortKey()) != 0);
+        };
+
+        while (out.size() < limit)
+        {
+            // имена основы, удалённые или заменённые наложением, пропускаются
+            while (inBase() && replaced()) base.Next();
+
+            const bool haveBase = inBase();
+            const bool haveAdded = added != m_added.end() && StartsWith(added->first, key);
+            if (!haveBase && !haveAdded) break;
+
+            if (haveAdded && (!haveBase || added->first < base.SortKey()))
+            {
+                out.push_back(added->second);
+                ++added;
+            }
+            else
+            {
+                out.push_back({ base.Name(), base.Id(), base.Duplicates() });
+                base.Next();
+            }
+        }
+        return out;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../core/Storage.h"
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Словарь "имя активного компонента -> номер записи" (.pnd), упорядоченный
+    // по ключам сортировки имён (Collation.h), то есть по алфавиту для человека:
+    // он же даёт алфавитный список и поиск по началу имени без учёта регистра.
+    // Имя могут носить несколько активных записей (восстановление удалённых):
+    // словарь указывает на первую по номеру и помнит, сколько ещё таких записей.
+    //
+    // Имена хранятся с фронтальным сжатием блоками по BlockSize: первое имя блока
+    // целиком, остальные — длиной общего с предыдущим префикса и суффиксом.
+    // Ключи в файле не хранятся: перед блоками лежит таблица их смещений, и поиск
+    // идёт двоичным поиском по ключам первых имён блоков прямо в загруженном
+    // буфере, а затем линейно внутри одного блока. Файл читается целиком одним чтением.
+    //
+    // Изменения за сеанс копятся в небольшом наложении (добавленные/удалённые
+    // имена) и сливаются с основой при Save(). Файл действителен только для того
+    // поколения .prd, с которым он записан; иначе владелец строит его заново.
+    // Поколение растёт и от изменений, не трогающих имён, — тогда Save()
+    // переписывает только заголовок.
+    class NameDictionary final
+    {
+    public:
+        static constexpr std::size_t BlockSize = 16;
+
+        // .prd -> .pnd рядом с ним
+        static std::string PathFor(const std::string& prdPath);
+
+        struct Entry
+        {
+            std::string name;
+            RecordId id = NullId;
+            std::uint32_t duplicates = 0; // других активных записей с этим именем
+        };
+
+        // заменить содержимое (порядок и уникальность entries не требуются;
+        // повторы имени сводятся к первой по номеру записи со счётчиком повторов)
+        void Assign(std::vector<Entry> entries);
+
+        // false — файла нет, он другого поколения или повреждён
+        bool Load(const std::string& path, StorageBackend backend, std::uint64_t generation);
+        void Save(const std::string& path, StorageBackend backend, std::uint64_t generation);
+
+        // файл на диске совпадает с содержимым и записан для этого поколения
+        bool SavedFor(std::uint64_t generation) const;
+
+        std::optional<RecordId> Find(std::string_view name) const;
+        std::optional<Entry> Lookup(std::string_view name) const;
+        // добавить имя или заменить его номер и счётчик повторов
+        void Insert(const std::string& name, RecordId id, std::uint32_t duplicates = 0);
+        void Erase(const std::string& name);
+
+        // имена, начинающиеся с prefix без учёта регистра, по алфавиту (пустой — все имена)
+        std::vector<Entry> WithPrefix(std::string_view prefix, std::size_t limit = SIZE_MAX) const;
+
+    private:
+        class Cursor;
+
+        // файл целиком: заголовок, таблица смещений блоков, блоки
+        std::vector<std::uint8_t> m_data;
+        std::uint64_t m_count = 0;
+        std::uint64_t m_blockCount = 0;
+
+        std::map<std::string, Entry, std::less<>> m_added; // по ключу сортировки имени
+        std::set<std::string, std::less<>> m_removed;      // имена
+        bool m_dirty = false;
+        // поколение файла на диске, совпадающего с m_data (после Load/Save)
+        std::optional<std::uint64_t> m_savedGeneration;
+
+        void Encode(const std::vector<Entry>& sorted, std::uint64_t generation);
+        std::string_view BlockHead(std::uint64_t block) const;
+        std::uint64_t FindBlock(std::string_view key) const;
+    };
+}
@@ -0,0 +1,132 @@
+#include "NameHeap.h"
+#include "RecordLayout.h"
+#include <algorithm>
+
+namespace ps
+{
+    static constexpr std::size_t HeaderSize = NameHeapHeaderLayout::FixedSize;
+
+    std::string NameHeap::PathFor(const std::string& prdPath)
+    {
+        const std::string ext = ".prd";
+        if (prdPath.size() >= ext.size() && prdPath.compare(prdPath.size() - ext.size(), ext.size(), ext) == 0)
+            return prdPath.substr(0, prdPath.size() - ext.size()) + ".prn";
+        return prdPath + ".prn";
+    }
+
+    void NameHeap::UseCache(PageCache* cache) { m_file.UseCache(cache); }
+
+    void NameHeap::Create(const std::string& path, StorageBackend backend)
+    {
+        Close();
+        m_file.Create(path, backend);
+
+        m_header = NameHeapHeader{};
+        m_header.version = FormatVersion;
+        m_header.size = HeaderSize;
+        m_headerDirty = true;
+        Flush();
+    }
+
+    void NameHeap::Open(const std::string& path, StorageBackend backend)
+    {
+        Close();
+        m_file.Open(path, backend);
+        LoadHeader();
+    }
+
+    void NameHeap::Reload()
+    {
+        m_file.Reload();
+        LoadHeader();
+    }
+
+    void NameHeap::LoadHeader()
+    {
+        if (m_file.Size() < HeaderSize) throw FileException("Файл имён повреждён: неполный заголовок.");
+        std::uint8_t block[HeaderSize];
+        m_file.Read(0, block, sizeof(block));
+        if (!NameHeapSignature::Matches(block))
+            throw FileException("Сигнатура файла имён отсутствует или неверна (ожидалось 'PSNH').");
+        NameHeapHeaderLayout::Decode(block, m_header);
+        CheckFormatVersion(m_header.version, m_header.flags);
+        m_headerDirty = false;
+
+        // заголовок мог попасть на диск раньше самих имён
+        if (m_header.size < HeaderSize) throw FileException("Файл имён повреждён: некорректный размер в заголовке.");
+        m_header.size = std::min(m_header.size, m_file.Size());
+        m_file.SetSize(m_header.size);
+    }
+
+    void NameHeap::Close()
+    {
+        if (m_file.IsOpen())
+        {
+            Flush();
+            // имена, дописанные другим процессом, не отрезаются вместе с запасом
+            std::uint8_t block[HeaderSize];
+            m_file.ReadStored(0, block, sizeof(block));
+            NameHeapHeader stored;
+            NameHeapHeaderLayout::Decode(block, stored);
+            if (stored.size > m_header.size) m_file.SetSize(stored.size);
+        }
+        m_file.Close();
+    }
+
+    bool NameHeap::IsOpen() const { return m_file.IsOpen(); }
+
+    std::uint64_t NameHeap::Append(const std::string& name, const std::string& sortKey)
+    {
+        if (sortKey.size() > UINT16_MAX) throw ValidationException("Слишком длинное имя компонента.");
+
+        const auto offset = m_header.size;
+        m_file.Write(offset, name.data(), name.size());
+        m_header.size += name.size();
+        if (!sortKey.empty())
+        {
+            const std::uint8_t len[2] = { static_cast<std::uint8_t>(sortKey.size()), static_cast<std::uint8_t>(sortKey.size() >> 8) };
+            m_file.Write(m_header.size, len, sizeof(len));
+            m_file.Write(m_header.size + sizeof(len), sortKey.data(), sortKey.size());
+            m_header.size += sizeof(len) + sortKey.size();
+        }
+        m_headerDirty = true;
+        return offset;
+    }
+
+    void NameHeap::Read(std::uint64_t offset, std::uint16_t len, std::string& out)
+    {
+        if (offset < HeaderSize || offset + len > m_header.size)
+            throw FileException("Ссылка на имя за пределами файла имён.");
+        out.resize(len);
+        m_file.Read(offset, out.data(), len);
+    }
+
+    void NameHeap::ReadKey(std::uint64_t offset, std::uint16_t nameLen, std::string& out)
+    {
+        const auto at = offset + nameLen;
+        std::uint8_t len[2];
+        if (offset < HeaderSize || at + sizeof(len) > m_header.size)
+            throw FileException("Ссылка на ключ сортировки за пределами файла имён.");
+        m_file.Read(at, len, sizeof(len));
+
+        const std::size_t keyLen = len[0] | (len[1] << 8);
+        if (at + sizeof(len) + keyLen > m_header.size)
+            throw FileException("Ссылка на ключ сортировки за пределами файла имён.");
+        out.resize(keyLen);
+        m_file.Read(at + sizeof(len), out.data(), keyLen);
+    }
+
+    std::uint64_t NameHeap::Size() const { return m_header.size; }
+
+    void NameHeap::Flush()
+    {
+        if (m_headerDirty)
+        {
+            std::uint8_t block[HeaderSize];
+            NameHeapHeaderLayout::Encode(m_header, block);
+            m_file.Write(0, block, sizeof(block));
+            m_headerDirty = false;
+        }
+        m_file.Flush();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "../core/PagedFile.h"
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Куча имён компонентов (.prn): байты имён подряд за заголовком, без
+    // разделителей и дополнения. Запись .prd хранит смещение и длину своего имени.
+    // Куча только растёт: при переименовании новое имя дописывается в конец,
+    // старое остаётся мусором до Truncate, который строит каталог заново.
+    //
+    // В каталогах с флагом ProductCollationKeys за каждым именем лежит его ключ
+    // сортировки: длина(2) и байты (см. Collation.h). Ссылка записи на имя от этого
+    // не меняется, а ключ находится сразу за именем.
+    class NameHeap final
+    {
+    public:
+        // .prd -> .prn рядом с ним
+        static std::string PathFor(const std::string& prdPath);
+
+        // общий кэш страниц; задаётся до Create/Open
+        void UseCache(PageCache* cache);
+
+        void Create(const std::string& path, StorageBackend backend);
+        void Open(const std::string& path, StorageBackend backend);
+        void Close();
+        bool IsOpen() const;
+        // перечитать кучу с диска: другой процесс дописал в неё имена
+        void Reload();
+
+        // дописать имя (и ключ сортировки, если он задан), вернуть смещение имени
+        std::uint64_t Append(const std::string& name, const std::string& sortKey = {});
+        void Read(std::uint64_t offset, std::uint16_t len, std::string& out);
+        // ключ сортировки имени по смещению offset и длине nameLen
+        void ReadKey(std::uint64_t offset, std::uint16_t nameLen, std::string& out);
+
+        // логический размер кучи вместе с заголовком
+        std::uint64_t Size() const;
+
+        void Flush();
+
+    private:
+        PagedFile m_file;
+        NameHeapHeader m_header;
+        bool m_headerDirty = false;
+
+        void LoadHeader();
+    };
+}
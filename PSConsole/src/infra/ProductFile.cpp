@@ -1,5 +1,10 @@
 #include "ProductFile.h"
+#include "../core/Profiling.h"
+#include "../domain/Collation.h"
+#include "ComponentScan.h"
 #include <algorithm>
+#include <map>
+#include <unordered_set>
 
 namespace ps
 {
@@ -11,146 +16,318 @@ namespace ps
         return s.substr(b, e - b + 1);
     }
 
-    void ProductFile::Create(const std::string& prdPath, std::uint16_t maxNameLen, const std::string& prsPath)
+    std::vector<std::string> ProductFile::SidecarPathsFor(const std::string& prdPath)
     {
+        return { NameHeap::PathFor(prdPath), NameDictionary::PathFor(prdPath) };
+    }
+
+    void ProductFile::Create(const std::string& prdPath, std::uint16_t maxNameLen, const std::string& prsPath, StorageBackend backend)
+    {
+        PS_PROFILE_SPAN("ProductFile::Create");
         if (maxNameLen == 0 || maxNameLen > 5000)
             throw ValidationException("Некорректная максимальная длина имени компонента.");
 
         m_prdPath = prdPath;
         m_prsPath = prsPath;
+        m_snapshot.Clear();
+
+        ProductFileHeader header;
+        header.dataLen = static_cast<std::uint16_t>(1 + maxNameLen);
+        header.version = FormatVersion;
+        header.flags = ProductCollationKeys | ProductRefCounts;
+        header.headId = NullId;
+        header.specFileName = prsPath;
+        m_file.Create(m_prdPath, header, backend);
+        m_names.Create(NameHeap::PathFor(m_prdPath), backend);
+        m_dict.Assign({});
+        RebuildNameFilter();
+        m_trigrams.Clear();
+        m_trigramsReady = false;
+    }
 
-        m_header.dataLen = static_cast<std::uint16_t>(1 + maxNameLen);
-        m_header.headPtr = NullPtr;
-        m_header.specFileName = prsPath;
+    void ProductFile::Open(const std::string& prdPath, StorageBackend backend)
+    {
+        PS_PROFILE_SPAN("ProductFile::Open");
+        m_prdPath = prdPath;
+        m_snapshot.Clear();
+        m_file.Open(m_prdPath, backend);
+        m_names.Open(NameHeap::PathFor(m_prdPath), backend);
+        m_prsPath = TrimSpaces(m_file.GetHeader().specFileName);
 
-        m_file.CreateRWTruncate(m_prdPath);
+        if ((m_file.GetHeader().flags & ProductCollationKeys) == 0) AddCollationKeys();
 
-        const char sig[2] = { 'P','S' };
-        m_file.WriteBytes(sig, 2);
-        m_file.WriteLE<std::uint16_t>(m_header.dataLen);
-        m_file.WriteLE<std::uint32_t>(m_header.headPtr);
-        m_file.WriteLE<std::uint32_t>(0);
-        m_file.WriteFixedString(m_prsPath, 16, ' ');
+        if (!m_dict.Load(NameDictionary::PathFor(m_prdPath), backend, m_file.GetHeader().generation))
+        {
+            std::vector<NameDictionary::Entry> active;
+            for (const auto& r : Records())
+                if (!r.deleted) active.push_back({ r.name, r.id });
+            m_dict.Assign(std::move(active));
+        }
+        RebuildNameFilter();
+        m_trigrams.Clear();
+        m_trigramsReady = false;
+    }
 
-        m_header.freePtr = static_cast<std::uint32_t>(m_file.Tell());
-        m_file.Seek(2 + 2 + 4);
-        m_file.WriteLE<std::uint32_t>(m_header.freePtr);
-        m_file.Flush();
+    void ProductFile::Close()
+    {
+        PS_PROFILE_SPAN("ProductFile::Close");
+        if (m_file.IsOpen() && m_names.IsOpen())
+        {
+            Flush();
+            // словарь пишется после .prd: при сбое между ними он окажется старого поколения
+            if (!m_dict.SavedFor(m_file.GetHeader().generation)) m_dict.Save(NameDictionary::PathFor(m_prdPath), m_file.Backend(), m_file.GetHeader().generation);
+        }
+        m_file.Close();
+        m_names.Close();
+        m_snapshot.Clear();
     }
 
-    void ProductFile::Open(const std::string& prdPath)
+    // Каталог, созданный до ключей сортировки: имена дописываются в кучу заново
+    // вместе с ключами (старые копии остаются мусором до Truncate), а алфавитный
+    // список, упорядоченный по байтам, перестраивается.
+    void ProductFile::AddCollationKeys()
     {
-        m_prdPath = prdPath;
-        m_file.OpenRW(m_prdPath);
-        ReadHeaderAndValidate();
-        m_prsPath = TrimSpaces(m_header.specFileName);
+        ComponentRecord r;
+        for (RecordId id = 1; id <= m_file.RecordCount(); id++)
+        {
+            ReadRecordInto(id, r);
+            r.nameOffset = AppendName(r.name);
+            m_file.WriteRecordAt(id, r);
+        }
+
+        m_file.MutableHeader().flags |= ProductCollationKeys;
+        RebuildAlphabeticalLinks();
     }
 
-    void ProductFile::Close() { m_file.Close(); }
-    bool ProductFile::IsOpen() const { return m_file.IsOpen(); }
+    std::uint64_t ProductFile::AppendName(const std::string& name) { return m_names.Append(name, CollationKey(name)); }
 
-    const ProductFileHeader& ProductFile::Header() const { return m_header; }
-    const std::string& ProductFile::PrdPath() const { return m_prdPath; }
-    const std::string& ProductFile::PrsPath() const { return m_prsPath; }
+    bool ProductFile::IsOpen() const { return m_file.IsOpen() && m_names.IsOpen(); }
 
-    std::uint16_t ProductFile::MaxNameLen() const { return static_cast<std::uint16_t>(m_header.dataLen - 1); }
-    std::uint64_t ProductFile::HeaderSize() const { return 2ull + 2ull + 4ull + 4ull + 16ull; }
+    void ProductFile::UseCache(PageCache* cache)
+    {
+        m_file.UseCache(cache);
+        m_names.UseCache(cache);
+    }
 
-    void ProductFile::WriteHeader()
+    void ProductFile::Flush()
     {
-        m_file.Seek(0);
-        const char sig[2] = { 'P','S' };
-        m_file.WriteBytes(sig, 2);
-        m_file.WriteLE<std::uint16_t>(m_header.dataLen);
-        m_file.WriteLE<std::uint32_t>(m_header.headPtr);
-        m_file.WriteLE<std::uint32_t>(m_header.freePtr);
-        m_file.WriteFixedString(m_header.specFileName, 16, ' ');
+        PS_PROFILE_SPAN("ProductFile::Flush");
+        m_names.Flush();
+        m_file.Flush();
     }
 
-    void ProductFile::ReadHeaderAndValidate()
+    void ProductFile::IndexName(const std::string& name, RecordId id, std::uint32_t duplicates)
     {
-        m_file.Seek(0);
-        char sig[2]{};
-        m_file.ReadBytes(sig, 2);
-        if (!(sig[0] == 'P' && sig[1] == 'S'))
-            throw FileException("Сигнатура файла отсутствует или неверна (ожидалось 'PS').");
+        m_dict.Insert(name, id, duplicates);
+        m_nameFilter.Add(name);
+        if (m_nameFilter.Saturated()) RebuildNameFilter();
+        if (m_trigramsReady) m_trigrams.Add(name);
+    }
 
-        m_file.ReadLE<std::uint16_t>(m_header.dataLen);
-        m_file.ReadLE<std::uint32_t>(m_header.headPtr);
-        m_file.ReadLE<std::uint32_t>(m_header.freePtr);
-        m_header.specFileName = m_file.ReadFixedString(16);
+    // Фильтр строится по словарю с запасом вдвое, чтобы не пересобирать его
+    // при каждом добавлении; удалённые имена из него уходят только здесь.
+    void ProductFile::RebuildNameFilter()
+    {
+        const auto names = m_dict.WithPrefix("");
+        m_nameFilter.Reset(names.size() * 2);
+        for (const auto& e : names) m_nameFilter.Add(e.name);
+    }
 
-        if (m_header.dataLen < 2)
-            throw FileException("Некорректная длина области данных (dataLen) в заголовке.");
+    void ProductFile::UnindexName(const std::string& name)
+    {
+        m_dict.Erase(name);
+        if (m_trigramsReady) m_trigrams.Remove(name);
     }
 
-    void ProductFile::WriteRecordAt(std::uint32_t offset, const ComponentRecord& rec)
+    // Имена могут повторяться (восстановление удалённых): словарь, как и прежний
+    // поиск перебором, указывает на первую по номеру активную запись с этим именем
+    // и хранит число остальных. Вызывается, когда запись id стала носить имя name.
+    void ProductFile::KeepName(const std::string& name, RecordId id)
     {
-        m_file.Seek(offset);
-        std::uint8_t del = rec.deleted ? 0xFF : 0;
-        m_file.WriteLE<std::uint8_t>(del);
-        m_file.WriteLE<std::uint32_t>(rec.firstSpecPtr);
-        m_file.WriteLE<std::uint32_t>(rec.nextPtr);
-        m_file.WriteLE<std::uint8_t>(static_cast<std::uint8_t>(rec.type));
-        m_file.WriteFixedString(rec.name, MaxNameLen(), ' ');
+        const auto current = m_dict.Lookup(name);
+        if (!current) IndexName(name, id);
+        else if (current->id != id) m_dict.Insert(name, std::min(current->id, id), current->duplicates + 1);
     }
 
-    std::uint32_t ProductFile::AppendRecord(const ComponentRecord& rec)
+    // вызывается после того, как запись id перестала носить имя name
+    void ProductFile::DropName(const std::string& name, RecordId id)
     {
-        auto offset = static_cast<std::uint32_t>(m_file.Size());
-        WriteRecordAt(offset, rec);
-        m_header.freePtr = static_cast<std::uint32_t>(m_file.Size());
-        WriteHeader();
-        m_file.Flush();
-        return offset;
+        const auto current = m_dict.Lookup(name);
+        if (!current) return;
+
+        if (current->duplicates == 0)
+        {
+            if (current->id == id) UnindexName(name);
+        }
+        else if (current->id != id)
+        {
+            m_dict.Insert(name, current->id, current->duplicates - 1);
+        }
+        else
+        {
+            // ушла первая из повторяющихся записей: следующую найти можно только перебором
+            RecountName(name);
+        }
     }
 
-    ComponentRecord ProductFile::ReadRecordAt(std::uint32_t offset)
+    void ProductFile::RecountName(const std::string& name)
     {
-        ComponentRecord rec;
-        rec.fileOffset = offset;
+        RecordId first = NullId;
+        std::uint32_t holders = 0;
+        for (const auto& r : m_file.Records())
+        {
+            if (r.deleted || r.nameLen != name.size()) continue;
+            m_names.Read(r.nameOffset, r.nameLen, m_nameBuf);
+            if (m_nameBuf != name) continue;
 
-        m_file.Seek(offset);
-        std::uint8_t del = 0;
-        m_file.ReadLE<std::uint8_t>(del);
-        rec.deleted = (del != 0);
+            if (holders++ == 0) first = r.id;
+        }
 
-        m_file.ReadLE<std::uint32_t>(rec.firstSpecPtr);
-        m_file.ReadLE<std::uint32_t>(rec.nextPtr);
+        if (holders == 0) UnindexName(name);
+        else IndexName(name, first, holders - 1);
+    }
 
-        std::uint8_t t = 0;
-        m_file.ReadLE<std::uint8_t>(t);
-        rec.type = static_cast<ComponentType>(t);
+    // индекс триграмм строится при первом поиске: Open() его не ждёт
+    void ProductFile::EnsureTrigrams()
+    {
+        if (m_trigramsReady) return;
 
-        rec.name = TrimSpaces(m_file.ReadFixedString(MaxNameLen()));
-        return rec;
+        m_trigrams.Clear();
+        for (const auto& e : m_dict.WithPrefix("")) m_trigrams.Add(e.name);
+        m_trigramsReady = true;
     }
 
-    std::vector<ComponentRecord> ProductFile::ReadAllRecords()
+    std::optional<ComponentRecord> ProductFile::ReadActiveByIndexedName(const std::string& name)
     {
-        std::vector<ComponentRecord> out;
-        auto sz = m_file.Size();
-        auto pos = HeaderSize();
-        const std::uint64_t recSize = 1ull + 4ull + 4ull + static_cast<std::uint64_t>(m_header.dataLen);
+        auto id = m_dict.Find(name);
+        if (!id || *id > m_file.RecordCount()) return std::nullopt;
 
-        while (pos + recSize <= sz)
+        auto r = ReadRecordAt(*id);
+        if (r.deleted || r.name != name) return std::nullopt;
+        return r;
+    }
+
+    void ProductFile::SortByCollation(std::vector<ComponentRecord>& records)
+    {
+        std::vector<std::pair<std::string, ComponentRecord>> keyed;
+        keyed.reserve(records.size());
+        for (auto& r : records)
         {
-            out.push_back(ReadRecordAt(static_cast<std::uint32_t>(pos)));
-            pos += recSize;
+            m_names.ReadKey(r.nameOffset, r.nameLen, m_keyBuf);
+            keyed.emplace_back(m_keyBuf, std::move(r));
         }
-        return out;
+        std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        records.clear();
+        for (auto& k : keyed) records.push_back(std::move(k.second));
     }
 
+    void ProductFile::Touch() { m_file.MutableHeader().generation++; }
+
+    const ProductFileHeader& ProductFile::Header() const { return m_file.GetHeader(); }
+    const std::string& ProductFile::PrdPath() const { return m_prdPath; }
+    const std::string& ProductFile::PrsPath() const { return m_prsPath; }
+
+    std::uint16_t ProductFile::MaxNameLen() const { return static_cast<std::uint16_t>(m_file.GetHeader().dataLen - 1); }
+
+    ComponentRecord ProductFile::ReadRecordAt(RecordId id)
+    {
+        PS_PROFILE_SPAN("ProductFile::ReadRecordAt");
+        ComponentRecord rec;
+        ReadRecordInto(id, rec);
+        return rec;
+    }
+
+    void ProductFile::ReadRecordInto(RecordId id, ComponentRecord& rec)
+    {
+        PS_PROFILE_SPAN("ProductFile::ReadRecordInto");
+        m_file.ReadRecordInto(id, rec);
+        m_names.Read(rec.nameOffset, rec.nameLen, rec.name);
+    }
+
+    ProductFile::RecordRange ProductFile::Records() { return RecordRange(*this, 1, m_file.RecordCount() + 1); }
+    ProductFile::ChainRange ProductFile::Alphabetical() { return ChainRange(*this, m_file.GetHeader().headId); }
+
     std::optional<ComponentRecord> ProductFile::FindActiveByName(const std::string& name)
     {
+        PS_PROFILE_SPAN("ProductFile::FindActiveByName");
         auto target = TrimSpaces(name);
-        for (const auto& r : ReadAllRecords())
-            if (!r.deleted && r.name == target) return r;
-        return std::nullopt;
+
+        // большинство новых имён отсеивается фильтром без поиска в словаре
+        if (!m_nameFilter.MayContain(target)) return std::nullopt;
+
+        return ReadActiveByIndexedName(target);
+    }
+
+    std::vector<ComponentRecord> ProductFile::FindActiveByPrefix(const std::string& prefix, std::size_t limit)
+    {
+        PS_PROFILE_SPAN("ProductFile::FindActiveByPrefix");
+        // словарь упорядочен по алфавиту: limit отсекает именно первые
+        std::vector<ComponentRecord> out;
+        for (const auto& e : m_dict.WithPrefix(TrimSpaces(prefix), limit))
+            if (auto r = ReadActiveByIndexedName(e.name)) out.push_back(std::move(*r));
+        return out;
+    }
+
+    std::vector<ComponentRecord> ProductFile::FindActiveContaining(const std::string& fragment, std::size_t limit)
+    {
+        PS_PROFILE_SPAN("ProductFile::FindActiveContaining");
+        EnsureTrigrams();
+
+        // индекс отбирает первые limit по алфавиту и отдаёт их в этом порядке
+        std::vector<ComponentRecord> out;
+        for (const auto& m : m_trigrams.Containing(TrimSpaces(fragment), limit))
+            if (auto r = ReadActiveByIndexedName(m.name)) out.push_back(std::move(*r));
+        return out;
+    }
+
+    std::vector<ComponentRecord> ProductFile::FindActiveSimilar(const std::string& text, std::size_t maxEdits, std::size_t limit)
+    {
+        PS_PROFILE_SPAN("ProductFile::FindActiveSimilar");
+        EnsureTrigrams();
+
+        std::vector<ComponentRecord> out;
+        for (const auto& m : m_trigrams.Similar(TrimSpaces(text), maxEdits, limit))
+            if (auto r = ReadActiveByIndexedName(m.name)) out.push_back(std::move(*r));
+        return out;
+    }
+
+    std::vector<ComponentRecord> ProductFile::Select(const ComponentQuery& query)
+    {
+        PS_PROFILE_SPAN("ProductFile::Select");
+        const ComponentScan scan(query);
+        const auto recordSize = m_file.RecordSize();
+        m_scanBuf.resize(ComponentScan::BlockRecords * recordSize);
+
+        std::vector<RecordId> candidates;
+        std::vector<ComponentRecord> out;
+        ComponentRecord r;
+        for (RecordId first = 1; first <= m_file.RecordCount(); first += ComponentScan::BlockRecords)
+        {
+            const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(ComponentScan::BlockRecords, m_file.RecordCount() - first + 1));
+            m_file.ReadRawRecords(first, count, m_scanBuf.data());
+
+            candidates.clear();
+            scan.FilterBlock(m_scanBuf.data(), count, recordSize, first, candidates);
+
+            // запись уже в блоке: декодируется оттуда, имя читается из кучи один раз
+            for (const auto id : candidates)
+            {
+                ComponentFileLayout::DecodeRecord(m_scanBuf.data() + (id - first) * recordSize, m_file.GetHeader(), r);
+                r.id = id;
+                m_names.Read(r.nameOffset, r.nameLen, r.name);
+                if (scan.NameBytes() != 0 && !scan.MatchName(reinterpret_cast<const std::uint8_t*>(r.name.data()))) continue;
+                out.push_back(std::move(r));
+            }
+        }
+
+        SortByCollation(out);
+        return out;
     }
 
     ComponentRecord ProductFile::AddComponent(const std::string& name, ComponentType type)
     {
+        PS_PROFILE_SPAN("ProductFile::AddComponent");
         auto nm = TrimSpaces(name);
         if (nm.empty()) throw ValidationException("Пустое имя компонента.");
         if (nm.size() > MaxNameLen()) throw ValidationException("Имя компонента длиннее maxNameLen (Create).");
@@ -158,97 +335,254 @@ namespace ps
 
         ComponentRecord newRec;
         newRec.deleted = false;
-        newRec.firstSpecPtr = NullPtr;
-        newRec.nextPtr = NullPtr;
+        newRec.firstSpecId = NullId;
+        newRec.nextId = NullId;
         newRec.type = type;
         newRec.name = nm;
-
-        auto newOffset = AppendRecord(newRec);
-        newRec.fileOffset = newOffset;
-
-        // вставка в алфавитный список
-        if (m_header.headPtr == NullPtr)
+        const auto key = CollationKey(nm);
+        newRec.nameOffset = m_names.Append(nm, key);
+        newRec.nameLen = static_cast<std::uint16_t>(nm.size());
+
+        // вставка в алфавитный список: сравниваются ключи сортировки, имена не читаются
+        RecordId prev = NullId;
+        RecordId cur = NullId;
+        for (const auto& curRec : m_file.Chain(m_file.GetHeader().headId))
         {
-            m_header.headPtr = newOffset;
-            WriteHeader();
-            m_file.Flush();
-            return newRec;
+            if (curRec.deleted)
+            {
+                prev = curRec.id;
+                continue;
+            }
+
+            m_names.ReadKey(curRec.nameOffset, curRec.nameLen, m_keyBuf);
+            if (m_keyBuf > key)
+            {
+                cur = curRec.id;
+                break;
+            }
+            prev = curRec.id;
         }
 
-        std::uint32_t prev = NullPtr;
-        std::uint32_t cur = m_header.headPtr;
+        newRec.nextId = (prev == NullId) ? m_file.GetHeader().headId : cur;
+        newRec.id = m_file.AppendRecord(newRec);
 
-        while (cur != NullPtr)
+        if (prev == NullId)
         {
-            auto curRec = ReadRecordAt(cur);
-            if (!curRec.deleted && curRec.name > nm) break;
-            prev = cur;
-            cur = curRec.nextPtr;
+            m_file.MutableHeader().headId = newRec.id;
         }
-
-        if (prev == NullPtr)
+        else
         {
-            newRec.nextPtr = m_header.headPtr;
-            WriteRecordAt(newOffset, newRec);
-            m_header.headPtr = newOffset;
-            WriteHeader();
-            m_file.Flush();
-            return newRec;
+            auto prevRec = m_file.ReadRecordAt(prev);
+            prevRec.nextId = newRec.id;
+            m_file.WriteRecordAt(prev, prevRec);
         }
 
-        auto prevRec = ReadRecordAt(prev);
-        newRec.nextPtr = cur;
-        WriteRecordAt(newOffset, newRec);
-        prevRec.nextPtr = newOffset;
-        WriteRecordAt(prev, prevRec);
-        m_file.Flush();
+        IndexName(nm, newRec.id);
+        Touch();
+        Flush();
         return newRec;
     }
 
-    void ProductFile::MarkDeleted(std::uint32_t offset, bool deleted)
+    RecordId ProductFile::AppendRecord(ComponentRecord rec)
     {
-        auto r = ReadRecordAt(offset);
+        PS_PROFILE_SPAN("ProductFile::AppendRecord");
+        rec.nameOffset = AppendName(rec.name);
+        rec.nameLen = static_cast<std::uint16_t>(rec.name.size());
+        const auto id = m_file.AppendRecord(rec);
+
+        if (!rec.deleted) KeepName(rec.name, id);
+        Touch();
+        return id;
+    }
+
+    void ProductFile::MarkDeleted(RecordId id, bool deleted)
+    {
+        PS_PROFILE_SPAN("ProductFile::MarkDeleted");
+        auto r = ReadRecordAt(id);
+        const bool wasDeleted = r.deleted;
         r.deleted = deleted;
-        WriteRecordAt(offset, r);
-        m_file.Flush();
+        m_file.WriteRecordAt(id, r);
+
+        if (deleted != wasDeleted)
+        {
+            if (deleted) DropName(r.name, id);
+            else KeepName(r.name, id);
+        }
+        Touch();
+        Flush();
     }
 
-    void ProductFile::UpdatePointers(std::uint32_t offset, std::uint32_t firstSpecPtr, std::uint32_t nextPtr)
+    void ProductFile::UpdatePointers(RecordId id, RecordId firstSpecId, RecordId nextId)
     {
-        auto r = ReadRecordAt(offset);
-        r.firstSpecPtr = firstSpecPtr;
-        r.nextPtr = nextPtr;
-        WriteRecordAt(offset, r);
-        m_file.Flush();
+        PS_PROFILE_SPAN("ProductFile::UpdatePointers");
+        auto r = m_file.ReadRecordAt(id);
+        r.firstSpecId = firstSpecId;
+        r.nextId = nextId;
+        m_file.WriteRecordAt(id, r);
+        Touch();
+        Flush();
     }
 
-    void ProductFile::UpdateComponent(std::uint32_t offset, const std::string& newName, ComponentType newType)
+    void ProductFile::AdjustReferences(RecordId id, std::int64_t delta)
     {
-        auto r = ReadRecordAt(offset);
-        r.name = TrimSpaces(newName);
-        r.type = newType;
-        WriteRecordAt(offset, r);
-        m_file.Flush();
+        PS_PROFILE_SPAN("ProductFile::AdjustReferences");
+        auto r = m_file.ReadRecordAt(id);
+        const auto count = static_cast<std::int64_t>(r.refCount) + delta;
+        if (count < 0 || count > UINT32_MAX) throw FileException("Счётчик ссылок на компонент вышел за допустимые пределы.");
+
+        r.refCount = static_cast<std::uint32_t>(count);
+        m_file.WriteRecordAt(id, r);
+        Touch();
+        Flush();
     }
 
+    void ProductFile::StoreReferenceCounts(const std::vector<std::uint32_t>& counts)
+    {
+        PS_PROFILE_SPAN("ProductFile::StoreReferenceCounts");
+        ComponentRecord r;
+        for (RecordId id = 1; id <= m_file.RecordCount(); id++)
+        {
+            m_file.ReadRecordInto(id, r);
+            r.refCount = id <= counts.size() ? counts[id - 1] : 0;
+            m_file.WriteRecordAt(id, r);
+        }
+
+        m_file.MutableHeader().flags |= ProductRefCounts;
+        Touch();
+        Flush();
+    }
+
+    bool ProductFile::HasReferenceCounts() const { return (m_file.GetHeader().flags & ProductRefCounts) != 0; }
+
+    void ProductFile::UpdateComponent(RecordId id, const std::string& newName, ComponentType newType)
+    {
+        PS_PROFILE_SPAN("ProductFile::UpdateComponent");
+        auto r = ReadRecordAt(id);
+        auto nm = TrimSpaces(newName);
+        if (nm != r.name)
+        {
+            r.nameOffset = AppendName(nm);
+            r.nameLen = static_cast<std::uint16_t>(nm.size());
+        }
+        r.type = newType;
+        const auto oldName = std::move(r.name);
+        r.name = nm;
+        m_file.WriteRecordAt(id, r);
+        if (!r.deleted && nm != oldName)
+        {
+            DropName(oldName, id);
+            KeepName(nm, id);
+        }
+        Touch();
+        Flush();
+    }
 
     void ProductFile::RebuildAlphabeticalLinks()
     {
-        auto all = ReadAllRecords();
-        std::vector<ComponentRecord> active;
-        for (auto& r : all) if (!r.deleted) active.push_back(r);
+        PS_PROFILE_SPAN("ProductFile::RebuildAlphabeticalLinks");
+        struct Entry
+        {
+            std::string key;
+            RecordId id;
+        };
 
-        std::sort(active.begin(), active.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+        std::vector<Entry> active;
+        for (const auto& r : m_file.Records())
+        {
+            if (r.deleted) continue;
+            m_names.ReadKey(r.nameOffset, r.nameLen, m_keyBuf);
+            active.push_back({ m_keyBuf, r.id });
+        }
 
+        std::sort(active.begin(), active.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+
+        ComponentRecord r;
         for (std::size_t i = 0; i < active.size(); i++)
         {
-            auto next = (i + 1 < active.size()) ? active[i + 1].fileOffset : NullPtr;
-            UpdatePointers(active[i].fileOffset, active[i].firstSpecPtr, static_cast<std::uint32_t>(next));
+            m_file.ReadRecordInto(active[i].id, r); // имя не нужно
+            r.nextId = (i + 1 < active.size()) ? active[i + 1].id : NullId;
+            m_file.WriteRecordAt(active[i].id, r);
         }
 
-        m_header.headPtr = active.empty() ? NullPtr : active.front().fileOffset;
-        m_header.freePtr = static_cast<std::uint32_t>(m_file.Size());
-        WriteHeader();
-        m_file.Flush();
+        m_file.MutableHeader().headId = active.empty() ? NullId : active.front().id;
+        Touch();
+        Flush();
+    }
+
+    void ProductFile::NoteSpecChange()
+    {
+        Touch();
+        Flush();
+    }
+
+    static bool SameState(const ProductFileHeader& a, const ProductFileHeader& b)
+    {
+        return a.generation == b.generation && a.recordCount == b.recordCount && a.headId == b.headId;
+    }
+
+    // Файл открывается заново по имени: открытый дескриптор после замены файла
+    // (переименованием) видел бы прежний, уже удалённый. Два процесса могут
+    // получить одно и то же поколение, если изменили каталог одновременно, —
+    // такое изменение заметит следующая сверка.
+    bool ProductFile::ChangedOnDisk()
+    {
+        return !SameState(Storage::ReadHeader(m_prdPath, m_file.Backend()), m_file.GetHeader());
+    }
+
+    bool ProductFile::ReplacedOnDisk()
+    {
+        const auto onDisk = Storage::ReadHeader(m_prdPath, m_file.Backend());
+        return !SameState(onDisk, m_file.StoredHeader()) || onDisk.recordCount < m_snapshot.RecordCount();
+    }
+
+    void ProductFile::TakeSnapshot() { m_snapshot.Take(m_file); }
+    void ProductFile::ClearSnapshot() { m_snapshot.Clear(); }
+    void ProductFile::RefreshSnapshot(RecordId id) { m_snapshot.Refresh(m_file, id); }
+    const ProductFile::Snapshot& ProductFile::GetSnapshot() const { return m_snapshot; }
+
+    std::vector<ProductFile::Snapshot::Change> ProductFile::ReloadChanged()
+    {
+        PS_PROFILE_SPAN("ProductFile::ReloadChanged");
+        // .prd раньше кучи: другой процесс пишет имя до записи, которая на него ссылается
+        Flush();
+        m_file.Reload();
+        m_names.Reload();
+
+        auto changes = m_snapshot.Update(m_file);
+        for (auto& c : changes)
+            if (c.before) m_names.Read(c.before->nameOffset, c.before->nameLen, c.before->name);
+
+        // Словарь — по затронутым именам: кто из изменённых записей носит имя теперь.
+        // Среди неизменённых записей имя носит только запись из словаря, если у
+        // имени не было повторов; иначе носители пересчитываются перебором.
+        std::map<std::string, std::vector<RecordId>> holders;
+        std::unordered_set<RecordId> changed;
+        ComponentRecord now;
+        for (const auto& c : changes)
+        {
+            changed.insert(c.id);
+            if (c.before && !c.before->deleted) holders[c.before->name];
+            ReadRecordInto(c.id, now);
+            if (!now.deleted) holders[now.name].push_back(c.id);
+        }
+
+        for (auto& [name, ids] : holders)
+        {
+            const auto current = m_dict.Lookup(name);
+            if (current && current->duplicates > 0)
+            {
+                RecountName(name);
+                continue;
+            }
+
+            if (current && changed.count(current->id) == 0) ids.push_back(current->id);
+            if (ids.empty())
+            {
+                if (current) UnindexName(name);
+                continue;
+            }
+            IndexName(name, *std::min_element(ids.begin(), ids.end()), static_cast<std::uint32_t>(ids.size() - 1));
+        }
+        return changes;
     }
 }
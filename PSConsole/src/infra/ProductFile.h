@@ -2,53 +2,137 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include "../core/BinaryIO.h"
+#include "../core/BloomFilter.h"
 #include "../domain/Models.h"
+#include "NameDictionary.h"
+#include "NameHeap.h"
+#include "RecordFile.h"
+#include "RecordLayout.h"
+#include "RecordSnapshot.h"
+#include "TrigramIndex.h"
 
 namespace ps
 {
+    // Файл компонентов: записи фиксированной длины в .prd и их имена в куче .prn.
+    // Записи, выдаваемые курсорами и ReadRecordAt/Into, приходят с прочитанным именем.
+    // Поиск по имени идёт через словарь активных имён .pnd (см. NameDictionary):
+    // каждое изменение .prd увеличивает поколение в заголовке, и словарь чужого
+    // поколения при Open() строится заново по записям.
     class ProductFile final
     {
     public:
-        void Create(const std::string& prdPath, std::uint16_t maxNameLen, const std::string& prsPath);
-        void Open(const std::string& prdPath);
+        using Storage = RecordFile<ComponentFileLayout>;
+        using RecordRange = RecordScan<ProductFile, ComponentRecord>;
+        using ChainRange = RecordChain<ProductFile, ComponentRecord>;
+        using Snapshot = RecordSnapshot<ComponentFileLayout>;
+
+        // файлы, сопровождающие .prd (куча имён, словарь); переносятся вместе с ним
+        static std::vector<std::string> SidecarPathsFor(const std::string& prdPath);
+
+        void Create(const std::string& prdPath, std::uint16_t maxNameLen, const std::string& prsPath,
+                    StorageBackend backend = DefaultStorageBackend);
+        void Open(const std::string& prdPath, StorageBackend backend = DefaultStorageBackend);
         void Close();
         bool IsOpen() const;
 
+        // общий кэш страниц; задаётся до Create/Open
+        void UseCache(PageCache* cache);
+
         const ProductFileHeader& Header() const;
         const std::string& PrdPath() const;
         const std::string& PrsPath() const;
 
         std::uint16_t MaxNameLen() const;
 
-        std::vector<ComponentRecord> ReadAllRecords();
-        ComponentRecord ReadRecordAt(std::uint32_t offset);
+        // все записи файла в физическом порядке, включая удалённые
+        RecordRange Records();
+        // алфавитный список, начиная с headPtr
+        ChainRange Alphabetical();
+
+        ComponentRecord ReadRecordAt(RecordId id);
+        void ReadRecordInto(RecordId id, ComponentRecord& rec);
         std::optional<ComponentRecord> FindActiveByName(const std::string& name);
+        // не более limit первых по алфавиту активных компонентов, имя которых
+        // начинается с prefix (без учёта регистра)
+        std::vector<ComponentRecord> FindActiveByPrefix(const std::string& prefix, std::size_t limit = SIZE_MAX);
+        // не более limit первых по алфавиту активных компонентов, имя которых
+        // содержит fragment (без учёта регистра)
+        std::vector<ComponentRecord> FindActiveContaining(const std::string& fragment, std::size_t limit);
+        // активные компоненты не дальше maxEdits правок от text, ближайшие первыми
+        std::vector<ComponentRecord> FindActiveSimilar(const std::string& text, std::size_t maxEdits, std::size_t limit);
+
+        // записи, удовлетворяющие query, по алфавиту (см. ComponentScan)
+        std::vector<ComponentRecord> Select(const ComponentQuery& query);
 
         ComponentRecord AddComponent(const std::string& name, ComponentType type);
 
-        void MarkDeleted(std::uint32_t offset, bool deleted);
-        void UpdatePointers(std::uint32_t offset, std::uint32_t firstSpecPtr, std::uint32_t nextPtr);
+        // Дописать запись как есть, без проверки имени и вставки в алфавитный список
+        // (перенос каталога из другого файла с сохранением номеров записей;
+        // список затем строится RebuildAlphabeticalLinks).
+        RecordId AppendRecord(ComponentRecord rec);
+
+        void MarkDeleted(RecordId id, bool deleted);
+        void UpdatePointers(RecordId id, RecordId firstSpecId, RecordId nextId);
+
+        // изменить счётчик ссылок на компонент (delta — +1/-1 при изменении спецификаций)
+        void AdjustReferences(RecordId id, std::int64_t delta);
+        // Записать счётчики всех записей заново (counts[id - 1]) и отметить их
+        // действительными — для каталога без флага ProductRefCounts.
+        void StoreReferenceCounts(const std::vector<std::uint32_t>& counts);
+        bool HasReferenceCounts() const;
 
         // изменить имя/тип компонента, не трогая ссылки и указатели
-        void UpdateComponent(std::uint32_t offset, const std::string& newName, ComponentType newType);
+        void UpdateComponent(RecordId id, const std::string& newName, ComponentType newType);
 
         void RebuildAlphabeticalLinks();
 
-    private:
-        static constexpr std::uint32_t NullPtr = 1;
+        // изменились только спецификации: поколение всё равно растёт, чтобы
+        // изменение увидели другие процессы, открывшие каталог
+        void NoteSpecChange();
+
+        // Сверка с изменениями другого процесса (см. CatalogService::PollExternalChanges).
+        // Заголовок .prd на диске отличается от открытого (поколение, число записей)
+        bool ChangedOnDisk();
+        // .prd на диске заменён целиком (Truncate) или стал короче снимка: сверять не с чем
+        bool ReplacedOnDisk();
+        // снимок записей; Open/Create/Close его сбрасывают
+        void TakeSnapshot();
+        void ClearSnapshot();
+        void RefreshSnapshot(RecordId id);
+        const Snapshot& GetSnapshot() const;
+        // Перечитать .prd и кучу имён с диска, поправить словарь и вернуть записи,
+        // изменившиеся со времени снимка (прежнее состояние — вместе с именем).
+        std::vector<Snapshot::Change> ReloadChanged();
 
-        ProductFileHeader m_header{};
+    private:
         std::string m_prdPath;
         std::string m_prsPath;
-        BinaryFile m_file;
-
-        std::uint64_t HeaderSize() const;
+        Storage m_file{ OperationCounter::ProductReads, OperationCounter::ProductWrites };
+        NameHeap m_names;
+        NameDictionary m_dict;
+        BloomFilter m_nameFilter; // активные имена: быстрый отказ в FindActiveByName
+        TrigramIndex m_trigrams;  // активные имена: поиск подстроки и с опечатками
+        bool m_trigramsReady = false;
+        Snapshot m_snapshot;
 
-        void WriteHeader();
-        void ReadHeaderAndValidate();
+        std::string m_nameBuf;
+        std::string m_keyBuf;
+        std::vector<std::uint8_t> m_scanBuf;
 
-        void WriteRecordAt(std::uint32_t offset, const ComponentRecord& rec);
-        std::uint32_t AppendRecord(const ComponentRecord& rec);
+        // куча имён сбрасывается раньше .prd: запись не должна ссылаться на имя, которого нет на диске
+        void Flush();
+        std::uint64_t AppendName(const std::string& name);
+        void AddCollationKeys();
+        void EnsureTrigrams();
+        std::optional<ComponentRecord> ReadActiveByIndexedName(const std::string& name);
+        void SortByCollation(std::vector<ComponentRecord>& records);
+        void IndexName(const std::string& name, RecordId id, std::uint32_t duplicates = 0);
+        void UnindexName(const std::string& name);
+        void RebuildNameFilter();
+        void KeepName(const std::string& name, RecordId id);
+        void DropName(const std::string& name, RecordId id);
+        void RecountName(const std::string& name);
+        // отметить изменение .prd: словарь прошлых поколений больше не годится
+        void Touch();
     };
 }
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Курсоры по записям фиксированной длины.
+    // Запись декодируется лениво, при переходе к ней, в буфер самого итератора:
+    // обход не выделяет память на каждую запись и может быть прерван обычным break.
+    // File должен предоставлять ReadRecordInto(RecordId, Record&).
+
+    // Последовательный обход всех записей файла (включая удалённые).
+    template<typename File, typename Record>
+    class RecordScan final
+    {
+    public:
+        class iterator final
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Record;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Record*;
+            using reference = const Record&;
+
+            iterator() = default;
+            iterator(File* file, RecordId id, RecordId end)
+                : m_file(file), m_id(id), m_end(end)
+            {
+                Load();
+            }
+
+            reference operator*() const { return m_rec; }
+            pointer operator->() const { return &m_rec; }
+
+            iterator& operator++()
+            {
+                ++m_id;
+                Load();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const iterator& other) const { return m_id == other.m_id; }
+            bool operator!=(const iterator& other) const { return m_id != other.m_id; }
+
+        private:
+            void Load()
+            {
+                if (m_id < m_end) m_file->ReadRecordInto(m_id, m_rec);
+            }
+
+            File* m_file = nullptr;
+            RecordId m_id = NullId;
+            RecordId m_end = NullId;
+            Record m_rec{};
+        };
+
+        // записи с номерами [first, end)
+        RecordScan(File& file, RecordId first, RecordId end)
+            : m_file(&file), m_first(first), m_end(end) {}
+
+        iterator begin() const { return iterator(m_file, m_first, m_end); }
+        iterator end() const { return iterator(m_file, m_end, m_end); }
+
+    private:
+        File* m_file;
+        RecordId m_first;
+        RecordId m_end;
+    };
+
+    // Обход односвязной цепочки по полю nextId (алфавитный список, спецификация).
+    template<typename File, typename Record>
+    class RecordChain final
+    {
+    public:
+        class iterator final
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Record;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Record*;
+            using reference = const Record&;
+
+            iterator() = default;
+            explicit iterator(File* file, RecordId cur)
+                : m_file(file), m_cur(cur)
+            {
+                Load();
+            }
+
+            reference operator*() const { return m_rec; }
+            pointer operator->() const { return &m_rec; }
+
+            iterator& operator++()
+            {
+                m_cur = m_rec.nextId;
+                Load();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const iterator& other) const { return m_cur == other.m_cur; }
+            bool operator!=(const iterator& other) const { return m_cur != other.m_cur; }
+
+        private:
+            void Load()
+            {
+                if (m_cur != NullId) m_file->ReadRecordInto(m_cur, m_rec);
+            }
+
+            File* m_file = nullptr;
+            RecordId m_cur = NullId;
+            Record m_rec{};
+        };
+
+        RecordChain(File& file, RecordId first) : m_file(&file), m_first(first) {}
+
+        iterator begin() const { return iterator(m_file, m_first); }
+        iterator end() const { return iterator(m_file, NullId); }
+
+    private:
+        File* m_file;
+        RecordId m_first;
+    };
+}
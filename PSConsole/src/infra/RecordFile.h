@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../core/OperationStats.h"
+#include "../core/PagedFile.h"
+#include "RecordCursor.h"
+
+namespace ps
+{
+    // Файл записей фиксированной длины: заголовок + записи подряд.
+    // Layout задаёт формат заголовка и записи (см. RecordLayout.h).
+    // Записи адресуются номером (RecordId, с 1): позиция = заголовок + (id - 1) * размер записи.
+    //
+    // Ввод-вывод идёт страницами через PageCache (см. PagedFile); запись может
+    // пересекать границу страницы. Логический конец файла задаётся числом записей
+    // в заголовке, а не физическим размером: хвост, выделенный с запасом и не
+    // отрезанный из-за аварийного завершения, игнорируется при следующем Open().
+    template<typename Layout>
+    class RecordFile final
+    {
+    public:
+        using Record = typename Layout::Record;
+        using Header = typename Layout::Header;
+        using RecordRange = RecordScan<RecordFile, Record>;
+        using ChainRange = RecordChain<RecordFile, Record>;
+
+        RecordFile() = default;
+        // прочитанные и записанные записи учитываются в счётчиках reads и writes
+        RecordFile(OperationCounter reads, OperationCounter writes) : m_readCounter(reads), m_writeCounter(writes) {}
+
+        // вызывать до Create/Open; кэш должен пережить файл
+        void UseCache(PageCache* cache) { m_file.UseCache(cache); }
+
+        void Create(const std::string& path, const Header& header, StorageBackend backend)
+        {
+            Close();
+            m_file.Create(path, backend);
+
+            m_header = header;
+            Layout::SetRecordCount(m_header, 0);
+            m_count = 0;
+            m_headerDirty = true;
+            Flush();
+        }
+
+        void Open(const std::string& path, StorageBackend backend)
+        {
+            Close();
+            m_file.Open(path, backend);
+            LoadHeader();
+        }
+
+        // Перечитать заголовок и записи с диска: файл изменил другой процесс.
+        // Свои изменения к этому моменту должны быть сброшены (Flush).
+        void Reload()
+        {
+            m_file.Reload();
+            LoadHeader();
+        }
+
+        // Заголовок файла path, открытого заново. Если он не совпадает со StoredHeader(),
+        // файл на диске заменён целиком (например, Truncate в другом процессе).
+        static Header ReadHeader(const std::string& path, StorageBackend backend)
+        {
+            BinaryFile file;
+            file.OpenRW(path, backend);
+            if (file.Size() < Layout::HeaderSize) throw FileException("Файл повреждён: неполный заголовок.");
+            std::uint8_t block[Layout::HeaderSize];
+            file.ReadAt(0, block, sizeof(block));
+            Header header;
+            Layout::DecodeHeader(block, header);
+            return header;
+        }
+
+        // заголовок в том виде, в каком он сейчас лежит на диске (мимо кэша)
+        Header StoredHeader()
+        {
+            std::uint8_t block[Layout::HeaderSize];
+            m_file.ReadStored(0, block, sizeof(block));
+            Header header;
+            Layout::DecodeHeader(block, header);
+            return header;
+        }
+
+        void Close()
+        {
+            if (m_file.IsOpen())
+            {
+                Flush();
+                // Другой процесс мог дописать записи после нашего Open/Reload: запас
+                // отрезается только за последней записью, известной заголовку на диске.
+                const auto stored = Layout::RecordCount(StoredHeader());
+                if (stored > m_count) m_file.SetSize(Layout::HeaderSize + stored * RecordSize());
+            }
+            m_file.Close();
+        }
+
+        bool IsOpen() const { return m_file.IsOpen(); }
+        StorageBackend Backend() const { return m_file.Backend(); }
+
+        const Header& GetHeader() const { return m_header; }
+
+        // изменённый заголовок будет записан при ближайшем Flush()
+        Header& MutableHeader()
+        {
+            m_headerDirty = true;
+            return m_header;
+        }
+
+        std::uint64_t HeaderSize() const { return Layout::HeaderSize; }
+        std::uint64_t RecordSize() const { return Layout::RecordSize(m_header); }
+
+        // логический размер файла с учётом ещё не сброшенных страниц
+        std::uint64_t Size() const { return m_file.Size(); }
+        std::uint64_t RecordCount() const { return m_count; }
+
+        void ReadRecordInto(RecordId id, Record& rec)
+        {
+            m_block.resize(RecordSize());
+            m_file.Read(Position(id), m_block.data(), m_block.size());
+            CountOperation(m_readCounter);
+            rec.id = id;
+            Layout::DecodeRecord(m_block.data(), m_header, rec);
+        }
+
+        Record ReadRecordAt(RecordId id)
+        {
+            Record rec;
+            ReadRecordInto(id, rec);
+            return rec;
+        }
+
+        // count записей подряд, начиная с first, байтами как в файле (для отбора без декодирования)
+        void ReadRawRecords(RecordId first, std::size_t count, std::uint8_t* out)
+        {
+            if (first == NullId || first + count - 1 > m_count) throw FileException("Запись с номером " + std::to_string(first + count - 1) + " отсутствует.");
+            m_file.Read(Position(first), out, count * RecordSize());
+            CountOperation(m_readCounter, count);
+        }
+
+        void WriteRecordAt(RecordId id, const Record& rec)
+        {
+            if (id == NullId || id > m_count) throw FileException("Запись с номером " + std::to_string(id) + " отсутствует.");
+            m_block.resize(RecordSize());
+            Layout::EncodeRecord(rec, m_header, m_block.data());
+            m_file.Write(Position(id), m_block.data(), m_block.size());
+            CountOperation(m_writeCounter);
+        }
+
+        RecordId AppendRecord(const Record& rec)
+        {
+            const RecordId id = ++m_count;
+            Layout::SetRecordCount(MutableHeader(), m_count);
+            WriteRecordAt(id, rec);
+            return id;
+        }
+
+        void MarkDeleted(RecordId id, bool deleted)
+        {
+            Record rec;
+            ReadRecordInto(id, rec);
+            rec.deleted = deleted;
+            WriteRecordAt(id, rec);
+        }
+
+        RecordRange Records() { return RecordRange(*this, 1, m_count + 1); }
+        ChainRange Chain(RecordId first) { return ChainRange(*this, first); }
+
+        // сбросить заголовок и все грязные страницы
+        void Flush()
+        {
+            if (m_headerDirty)
+            {
+                std::uint8_t block[Layout::HeaderSize];
+                Layout::EncodeHeader(m_header, block);
+                m_file.Write(0, block, sizeof(block));
+                m_headerDirty = false;
+            }
+
+            m_file.Flush();
+        }
+
+    private:
+        PagedFile m_file;
+        OperationCounter m_readCounter = OperationCounter::None;
+        OperationCounter m_writeCounter = OperationCounter::None;
+        Header m_header{};
+        bool m_headerDirty = false;
+
+        std::uint64_t m_count = 0; // записей в файле
+
+        std::vector<std::uint8_t> m_block; // буфер одной записи
+
+        void LoadHeader()
+        {
+            const auto physSize = m_file.Size();
+            if (physSize < Layout::HeaderSize) throw FileException("Файл повреждён: неполный заголовок.");
+            std::uint8_t block[Layout::HeaderSize];
+            m_file.Read(0, block, sizeof(block));
+            Layout::DecodeHeader(block, m_header);
+            m_headerDirty = false;
+
+            // записей не больше, чем помещается в файле: заголовок мог попасть на диск раньше записей
+            const auto physCount = (physSize - Layout::HeaderSize) / RecordSize();
+            m_count = std::min(Layout::RecordCount(m_header), physCount);
+            m_file.SetSize(Layout::HeaderSize + m_count * RecordSize());
+        }
+
+        std::uint64_t Position(RecordId id) const
+        {
+            if (id == NullId) throw FileException("Обращение по пустой ссылке на запись.");
+            return Layout::HeaderSize + (id - 1) * RecordSize();
+        }
+    };
+}
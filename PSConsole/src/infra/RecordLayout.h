@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "../core/Errors.h"
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Описание раскладки записи на диске.
+    // Каждое поле задаётся указателем на член записи, смещением и типом на диске;
+    // смещения и размеры известны на этапе компиляции, поэтому Decode/Encode
+    // разворачиваются в последовательность memcpy фиксированной длины по одному
+    // буферу, прочитанному или записанному за одну операцию.
+
+    template<auto Member, std::size_t Offset, typename Disk>
+    struct Field;
+
+    template<typename Record, typename Value, Value Record::* Member, std::size_t Offset, typename Disk>
+    struct Field<Member, Offset, Disk>
+    {
+        static_assert(std::is_trivially_copyable_v<Disk>);
+
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t size = sizeof(Disk);
+
+        static void Load(const std::uint8_t* block, Record& rec)
+        {
+            Disk d{};
+            std::memcpy(&d, block + Offset, sizeof(Disk));
+            if constexpr (std::is_same_v<Value, bool>) rec.*Member = (d != 0);
+            else rec.*Member = static_cast<Value>(d);
+        }
+
+        static void Store(const Record& rec, std::uint8_t* block)
+        {
+            Disk d{};
+            if constexpr (std::is_same_v<Value, bool>) d = rec.*Member ? static_cast<Disk>(0xFF) : Disk{};
+            else d = static_cast<Disk>(rec.*Member);
+            std::memcpy(block + Offset, &d, sizeof(Disk));
+        }
+    };
+
+    // Строка фиксированной ширины, дополненная Pad. При чтении возвращается как есть.
+    template<auto Member, std::size_t Offset, std::size_t Width, char Pad = ' '>
+    struct FixedStringField;
+
+    template<typename Record, std::string Record::* Member, std::size_t Offset, std::size_t Width, char Pad>
+    struct FixedStringField<Member, Offset, Width, Pad>
+    {
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t size = Width;
+
+        static void Load(const std::uint8_t* block, Record& rec)
+        {
+            (rec.*Member).assign(reinterpret_cast<const char*>(block + Offset), Width);
+        }
+
+        static void Store(const Record& rec, std::uint8_t* block)
+        {
+            const auto& value = rec.*Member;
+            const auto len = std::min(value.size(), Width);
+            std::memcpy(block + Offset, value.data(), len);
+            std::memset(block + Offset + len, Pad, Width - len);
+        }
+    };
+
+    // Сигнатура файла: записывается константой, при чтении только проверяется через Matches.
+    template<std::size_t Offset, char... Chars>
+    struct SignatureField
+    {
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t size = sizeof...(Chars);
+        static constexpr char value[] = { Chars... };
+
+        template<typename Record> static void Load(const std::uint8_t*, Record&) {}
+        template<typename Record> static void Store(const Record&, std::uint8_t* block) { std::memcpy(block + Offset, value, size); }
+
+        static bool Matches(const std::uint8_t* block) { return std::memcmp(block + Offset, value, size) == 0; }
+    };
+
+    // Зарезервированные байты: записываются нулями, при чтении пропускаются.
+    template<std::size_t Offset, std::size_t Size>
+    struct ReservedField
+    {
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t size = Size;
+
+        template<typename Record> static void Load(const std::uint8_t*, Record&) {}
+        template<typename Record> static void Store(const Record&, std::uint8_t* block) { std::memset(block + Offset, 0, Size); }
+    };
+
+    template<typename Record, typename... Fields>
+    struct RecordLayout
+    {
+        // размер фиксированной части записи (до хвоста переменной ширины, если он есть)
+        static constexpr std::size_t FixedSize = std::max({ (Fields::offset + Fields::size)... });
+
+        static_assert((Fields::size + ...) == FixedSize, "Поля раскладки должны идти без пропусков и перекрытий.");
+
+        static void Decode(const std::uint8_t* block, Record& rec) { (Fields::Load(block, rec), ...); }
+        static void Encode(const Record& rec, std::uint8_t* block) { (Fields::Store(rec, block), ...); }
+    };
+
+    // Версия формата файлов каталога и флаги необязательных возможностей.
+    // Файл с неизвестным флагом не открывается: программа не должна изменять
+    // данные, смысла которых она не знает.
+    constexpr std::uint16_t FormatVersion = 2;
+
+    // .prd: за именами в куче лежат ключи сортировки, алфавитный список упорядочен по ним
+    constexpr std::uint16_t ProductCollationKeys = 0x0001;
+    // .prd: в записях ведётся refCount (в каталогах без флага поле не заполнено)
+    constexpr std::uint16_t ProductRefCounts = 0x0002;
+
+    constexpr std::uint16_t KnownFormatFlags = ProductCollationKeys | ProductRefCounts;
+
+    // .pnd: у имени, кроме номера записи, хранится число других активных записей
+    // с тем же именем. Словарь без флага строится заново.
+    constexpr std::uint16_t DictionaryDuplicateCounts = 0x0001;
+    // .pnd: имена упорядочены по ключам сортировки (Collation.h), а не по байтам
+    constexpr std::uint16_t DictionaryCollationOrder = 0x0002;
+    constexpr std::uint16_t DictionaryFlags = DictionaryDuplicateCounts | DictionaryCollationOrder;
+
+    inline void CheckFormatVersion(std::uint16_t version, std::uint16_t flags)
+    {
+        if (version != FormatVersion)
+            throw FileException("Неподдерживаемая версия формата файла: " + std::to_string(version) + ".");
+        if ((flags & ~KnownFormatFlags) != 0)
+            throw FileException("Файл использует неизвестные возможности формата (флаги " + std::to_string(flags) + ").");
+    }
+
+    // .prd: del(1) type(1) nameLen(2) refCount(4) firstSpecId(8) nextId(8) nameOffset(8)
+    // Само имя хранится в куче имён (.prn), запись ссылается на него смещением и длиной.
+    using ComponentLayout = RecordLayout<ComponentRecord,
+        Field<&ComponentRecord::deleted, 0, std::uint8_t>,
+        Field<&ComponentRecord::type, 1, std::uint8_t>,
+        Field<&ComponentRecord::nameLen, 2, std::uint16_t>,
+        Field<&ComponentRecord::refCount, 4, std::uint32_t>,
+        Field<&ComponentRecord::firstSpecId, 8, std::uint64_t>,
+        Field<&ComponentRecord::nextId, 16, std::uint64_t>,
+        Field<&ComponentRecord::nameOffset, 24, std::uint64_t>>;
+
+    // .prs: del(1) резерв(1) qty(2) резерв(4) componentId(8) nextId(8)
+    using SpecLayout = RecordLayout<SpecRecord,
+        Field<&SpecRecord::deleted, 0, std::uint8_t>,
+        ReservedField<1, 1>,
+        Field<&SpecRecord::qty, 2, std::uint16_t>,
+        ReservedField<4, 4>,
+        Field<&SpecRecord::componentId, 8, std::uint64_t>,
+        Field<&SpecRecord::nextId, 16, std::uint64_t>>;
+
+    // Заголовки файлов.
+    using ProductSignature = SignatureField<0, 'P', 'S', 'P', 'R'>;
+    using SpecSignature = SignatureField<0, 'P', 'S', 'S', 'P'>;
+    using NameHeapSignature = SignatureField<0, 'P', 'S', 'N', 'H'>;
+    using NameDictionarySignature = SignatureField<0, 'P', 'S', 'N', 'D'>;
+
+    // .prd: 'PSPR'(4) version(2) flags(2) dataLen(2) резерв(6) headId(8) recordCount(8) имя .prs(32) generation(8) резерв(24)
+    using ProductHeaderLayout = RecordLayout<ProductFileHeader,
+        ProductSignature,
+        Field<&ProductFileHeader::version, 4, std::uint16_t>,
+        Field<&ProductFileHeader::flags, 6, std::uint16_t>,
+        Field<&ProductFileHeader::dataLen, 8, std::uint16_t>,
+        ReservedField<10, 6>,
+        Field<&ProductFileHeader::headId, 16, std::uint64_t>,
+        Field<&ProductFileHeader::recordCount, 24, std::uint64_t>,
+        FixedStringField<&ProductFileHeader::specFileName, 32, 32>,
+        Field<&ProductFileHeader::generation, 64, std::uint64_t>,
+        ReservedField<72, 24>>;
+
+    // .prs: 'PSSP'(4) version(2) flags(2) резерв(8) headId(8) recordCount(8) резерв(32)
+    using SpecHeaderLayout = RecordLayout<SpecFileHeader,
+        SpecSignature,
+        Field<&SpecFileHeader::version, 4, std::uint16_t>,
+        Field<&SpecFileHeader::flags, 6, std::uint16_t>,
+        ReservedField<8, 8>,
+        Field<&SpecFileHeader::headId, 16, std::uint64_t>,
+        Field<&SpecFileHeader::recordCount, 24, std::uint64_t>,
+        ReservedField<32, 32>>;
+
+    // .prn: 'PSNH'(4) version(2) flags(2) резерв(8) size(8) резерв(8), далее байты имён подряд
+    using NameHeapHeaderLayout = RecordLayout<NameHeapHeader,
+        NameHeapSignature,
+        Field<&NameHeapHeader::version, 4, std::uint16_t>,
+        Field<&NameHeapHeader::flags, 6, std::uint16_t>,
+        ReservedField<8, 8>,
+        Field<&NameHeapHeader::size, 16, std::uint64_t>,
+        ReservedField<24, 8>>;
+
+    // .pnd: 'PSND'(4) version(2) flags(2) generation(8) count(8) blockCount(8),
+    // далее смещения блоков (8 * blockCount) и сами блоки
+    using NameDictionaryHeaderLayout = RecordLayout<NameDictionaryHeader,
+        NameDictionarySignature,
+        Field<&NameDictionaryHeader::version, 4, std::uint16_t>,
+        Field<&NameDictionaryHeader::flags, 6, std::uint16_t>,
+        Field<&NameDictionaryHeader::generation, 8, std::uint64_t>,
+        Field<&NameDictionaryHeader::count, 16, std::uint64_t>,
+        Field<&NameDictionaryHeader::blockCount, 24, std::uint64_t>>;
+
+    // Описания файлов целиком для RecordFile<Layout>: заголовок, запись, проверка
+    // заголовка и число записей, по которому определяется логический конец файла.
+    struct ComponentFileLayout
+    {
+        using Record = ComponentRecord;
+        using Header = ProductFileHeader;
+
+        static constexpr std::size_t HeaderSize = ProductHeaderLayout::FixedSize;
+
+        // dataLen (1 + maxNameLen) ограничивает длину имени, но не размер записи
+        static std::size_t RecordSize(const Header&) { return ComponentLayout::FixedSize; }
+
+        static std::uint64_t RecordCount(const Header& h) { return h.recordCount; }
+        static void SetRecordCount(Header& h, std::uint64_t count) { h.recordCount = count; }
+
+        static void DecodeHeader(const std::uint8_t* block, Header& h)
+        {
+            if (!ProductSignature::Matches(block))
+                throw FileException("Сигнатура файла отсутствует или неверна (ожидалось 'PSPR').");
+
+            ProductHeaderLayout::Decode(block, h);
+            CheckFormatVersion(h.version, h.flags);
+            if (h.dataLen < 2)
+                throw FileException("Некорректная длина области данных (dataLen) в заголовке.");
+        }
+
+        static void EncodeHeader(const Header& h, std::uint8_t* block) { ProductHeaderLayout::Encode(h, block); }
+
+        // имя не заполняется: его читает ProductFile из кучи имён
+        static void DecodeRecord(const std::uint8_t* block, const Header&, Record& rec) { ComponentLayout::Decode(block, rec); }
+        static void EncodeRecord(const Record& rec, const Header&, std::uint8_t* block) { ComponentLayout::Encode(rec, block); }
+    };
+
+    struct SpecFileLayout
+    {
+        using Record = SpecRecord;
+        using Header = SpecFileHeader;
+
+        static constexpr std::size_t HeaderSize = SpecHeaderLayout::FixedSize;
+
+        static std::size_t RecordSize(const Header&) { return SpecLayout::FixedSize; }
+
+        static std::uint64_t RecordCount(const Header& h) { return h.recordCount; }
+        static void SetRecordCount(Header& h, std::uint64_t count) { h.recordCount = count; }
+
+        static void DecodeHeader(const std::uint8_t* block, Header& h)
+        {
+            if (!SpecSignature::Matches(block))
+                throw FileException("Сигнатура файла спецификаций отсутствует или неверна (ожидалось 'PSSP').");
+
+            SpecHeaderLayout::Decode(block, h);
+            CheckFormatVersion(h.version, h.flags);
+        }
+
+        static void EncodeHeader(const Header& h, std::uint8_t* block) { SpecHeaderLayout::Encode(h, block); }
+
+        static void DecodeRecord(const std::uint8_t* block, const Header&, Record& rec) { SpecLayout::Decode(block, rec); }
+        static void EncodeRecord(const Record& rec, const Header&, std::uint8_t* block) { SpecLayout::Encode(rec, block); }
+    };
+}
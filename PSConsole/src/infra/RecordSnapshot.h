@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include "RecordFile.h"
+
+namespace ps
+{
+    // Записи файла байтами, как они были при последней сверке. По снимку после
+    // изменений, сделанных другим процессом, находятся записи, которые с тех пор
+    // изменились или появились (Update), — без перечитывания всего каталога
+    // в окно. Снимок занимает столько же памяти, сколько сами записи.
+    template<typename Layout>
+    class RecordSnapshot final
+    {
+    public:
+        using Record = typename Layout::Record;
+        using Header = typename Layout::Header;
+
+        struct Change
+        {
+            RecordId id = NullId;
+            std::optional<Record> before; // пусто у записи, которой не было в снимке
+        };
+
+        static constexpr std::size_t BlockRecords = 1024;
+
+        void Clear()
+        {
+            m_bytes.clear();
+            m_bytes.shrink_to_fit();
+            m_recordSize = 0;
+            m_count = 0;
+        }
+
+        std::uint64_t RecordCount() const { return m_count; }
+
+        void Take(RecordFile<Layout>& file)
+        {
+            Clear();
+            Update(file);
+        }
+
+        // Сверить снимок с файлом и запомнить новое состояние. Число записей
+        // в файле не должно уменьшиться: файл, перестроенный заново, сверять не с чем.
+        std::vector<Change> Update(RecordFile<Layout>& file)
+        {
+            m_header = file.GetHeader();
+            m_recordSize = file.RecordSize();
+            const auto count = file.RecordCount();
+            if (count < m_count) throw FileException("Файл записей перестроен: сверка со снимком невозможна.");
+
+            std::vector<Change> changes;
+            m_bytes.resize(count * m_recordSize);
+            for (RecordId first = 1; first <= count; first += BlockRecords)
+            {
+                const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(BlockRecords, count - first + 1));
+                m_block.resize(n * m_recordSize);
+                file.ReadRawRecords(first, n, m_block.data());
+
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    const RecordId id = first + i;
+                    const auto* now = m_block.data() + i * m_recordSize;
+                    auto* was = Bytes(id);
+                    if (id > m_count)
+                    {
+                        changes.push_back({ id, std::nullopt });
+                    }
+                    else if (std::memcmp(now, was, m_recordSize) != 0)
+                    {
+                        changes.push_back({ id, At(id) });
+                    }
+                    else
+                    {
+                        continue;
+                    }
+                    std::memcpy(was, now, m_recordSize);
+                }
+            }
+            m_count = count;
+            return changes;
+        }
+
+        // Запомнить записи по id включительно в нынешнем виде — после своих
+        // изменений, чтобы при сверке они не выглядели чужими.
+        void Refresh(RecordFile<Layout>& file, RecordId id)
+        {
+            if (m_recordSize == 0 || id == NullId || id > file.RecordCount()) return;
+
+            const auto first = std::min<std::uint64_t>(id, m_count + 1);
+            m_bytes.resize(std::max(m_count, id) * m_recordSize);
+            file.ReadRawRecords(first, static_cast<std::size_t>(id - first + 1), Bytes(first));
+            m_count = std::max(m_count, id);
+        }
+
+        // запись из снимка (для ComponentRecord — без имени)
+        Record At(RecordId id) const
+        {
+            Record rec;
+            Layout::DecodeRecord(Bytes(id), m_header, rec);
+            rec.id = id;
+            return rec;
+        }
+
+    private:
+        Header m_header{};
+        std::size_t m_recordSize = 0;
+        std::uint64_t m_count = 0;
+        std::vector<std::uint8_t> m_bytes;
+        std::vector<std::uint8_t> m_block;
+
+        std::uint8_t* Bytes(RecordId id) { return m_bytes.data() + (id - 1) * m_recordSize; }
+        const std::uint8_t* Bytes(RecordId id) const { return m_bytes.data() + (id - 1) * m_recordSize; }
+    };
+}
@@ -1,158 +1,126 @@
 #include "SpecFile.h"
+#include "../core/Profiling.h"
 
 namespace ps
 {
-    void SpecFile::Create(const std::string& prsPath)
+    void SpecFile::Create(const std::string& prsPath, StorageBackend backend)
     {
+        PS_PROFILE_SPAN("SpecFile::Create");
         m_prsPath = prsPath;
-        m_file.CreateRWTruncate(m_prsPath);
-        WriteHeader(NullPtr, static_cast<std::uint32_t>(HeaderSize()));
-        m_file.Flush();
+        m_snapshot.Clear();
+
+        SpecFileHeader header;
+        header.version = FormatVersion;
+        header.headId = NullId;
+        m_file.Create(m_prsPath, header, backend);
     }
 
-    void SpecFile::Open(const std::string& prsPath)
+    void SpecFile::Open(const std::string& prsPath, StorageBackend backend)
     {
+        PS_PROFILE_SPAN("SpecFile::Open");
         m_prsPath = prsPath;
-        m_file.OpenRW(m_prsPath);
-        std::uint32_t h=0,f=0;
-        ReadHeader(h,f);
+        m_snapshot.Clear();
+        m_file.Open(m_prsPath, backend);
     }
 
-    void SpecFile::Close() { m_file.Close(); }
-    bool SpecFile::IsOpen() const { return m_file.IsOpen(); }
-
-    std::uint64_t SpecFile::HeaderSize() const { return 8ull; }
-
-    void SpecFile::WriteHeader(std::uint32_t headPtr, std::uint32_t freePtr)
+    void SpecFile::Close()
     {
-        m_file.Seek(0);
-        m_file.WriteLE<std::uint32_t>(headPtr);
-        m_file.WriteLE<std::uint32_t>(freePtr);
+        PS_PROFILE_SPAN("SpecFile::Close");
+        m_file.Close();
+        m_snapshot.Clear();
     }
 
-    void SpecFile::ReadHeader(std::uint32_t& headPtr, std::uint32_t& freePtr)
-    {
-        m_file.Seek(0);
-        m_file.ReadLE<std::uint32_t>(headPtr);
-        m_file.ReadLE<std::uint32_t>(freePtr);
-    }
+    std::uint64_t SpecFile::RecordCount() const { return m_file.RecordCount(); }
 
-    void SpecFile::WriteRecordAt(std::uint32_t offset, const SpecRecord& rec)
-    {
-        m_file.Seek(offset);
-        std::uint8_t del = rec.deleted ? 0xFF : 0;
-        m_file.WriteLE<std::uint8_t>(del);
-        m_file.WriteLE<std::uint32_t>(rec.componentPtr);
-        m_file.WriteLE<std::uint16_t>(rec.qty);
-        m_file.WriteLE<std::uint32_t>(rec.nextPtr);
-    }
+    bool SpecFile::IsOpen() const { return m_file.IsOpen(); }
+    void SpecFile::UseCache(PageCache* cache) { m_file.UseCache(cache); }
 
-    std::uint32_t SpecFile::AppendRecord(const SpecRecord& rec)
+    SpecRecord SpecFile::ReadRecordAt(RecordId id)
     {
-        auto offset = static_cast<std::uint32_t>(m_file.Size());
-        WriteRecordAt(offset, rec);
-
-        std::uint32_t head=0, free=0;
-        ReadHeader(head, free);
-        free = static_cast<std::uint32_t>(m_file.Size());
-        WriteHeader(head, free);
-
-        m_file.Flush();
-        return offset;
+        PS_PROFILE_SPAN("SpecFile::ReadRecordAt");
+        return m_file.ReadRecordAt(id);
     }
 
-    SpecRecord SpecFile::ReadRecordAt(std::uint32_t offset)
+    void SpecFile::ReadRecordInto(RecordId id, SpecRecord& rec)
     {
-        SpecRecord rec;
-        rec.fileOffset = offset;
-
-        m_file.Seek(offset);
-        std::uint8_t del = 0;
-        m_file.ReadLE<std::uint8_t>(del);
-        rec.deleted = (del != 0);
-
-        m_file.ReadLE<std::uint32_t>(rec.componentPtr);
-        m_file.ReadLE<std::uint16_t>(rec.qty);
-        m_file.ReadLE<std::uint32_t>(rec.nextPtr);
-        return rec;
+        PS_PROFILE_SPAN("SpecFile::ReadRecordInto");
+        m_file.ReadRecordInto(id, rec);
     }
 
-    std::vector<SpecRecord> SpecFile::ReadAllRecords()
-    {
-        std::vector<SpecRecord> out;
-        auto sz = m_file.Size();
-        auto pos = HeaderSize();
-        const std::uint64_t recSize = 1ull + 4ull + 2ull + 4ull;
+    SpecFile::RecordRange SpecFile::Records() { return m_file.Records(); }
+    SpecFile::ChainRange SpecFile::Chain(RecordId firstSpecId) { return m_file.Chain(firstSpecId); }
 
-        while (pos + recSize <= sz)
-        {
-            out.push_back(ReadRecordAt(static_cast<std::uint32_t>(pos)));
-            pos += recSize;
-        }
-        return out;
-    }
-
-    std::uint32_t SpecFile::AddSpecItem(std::uint32_t componentPtr, std::uint16_t qty)
+    RecordId SpecFile::AddSpecItem(RecordId componentId, std::uint16_t qty)
     {
+        PS_PROFILE_SPAN("SpecFile::AddSpecItem");
         SpecRecord r;
         r.deleted = false;
-        r.componentPtr = componentPtr;
+        r.componentId = componentId;
         r.qty = qty;
-        r.nextPtr = NullPtr;
-        return AppendRecord(r);
+        r.nextId = NullId;
+
+        auto id = m_file.AppendRecord(r);
+        m_file.Flush();
+        return id;
     }
 
-    void SpecFile::MarkDeleted(std::uint32_t offset, bool deleted)
+    void SpecFile::MarkDeleted(RecordId id, bool deleted)
     {
-        auto r = ReadRecordAt(offset);
-        r.deleted = deleted;
-        WriteRecordAt(offset, r);
+        PS_PROFILE_SPAN("SpecFile::MarkDeleted");
+        m_file.MarkDeleted(id, deleted);
         m_file.Flush();
     }
 
-    void SpecFile::UpdateNext(std::uint32_t offset, std::uint32_t nextPtr)
+    void SpecFile::UpdateNext(RecordId id, RecordId nextId)
     {
-        auto r = ReadRecordAt(offset);
-        r.nextPtr = nextPtr;
-        WriteRecordAt(offset, r);
+        PS_PROFILE_SPAN("SpecFile::UpdateNext");
+        auto r = m_file.ReadRecordAt(id);
+        r.nextId = nextId;
+        m_file.WriteRecordAt(id, r);
         m_file.Flush();
     }
 
-    void SpecFile::UpdateSpecItem(std::uint32_t offset, std::uint32_t componentPtr, std::uint16_t qty)
+    void SpecFile::UpdateSpecItem(RecordId id, RecordId componentId, std::uint16_t qty)
     {
-        auto r = ReadRecordAt(offset);
-        r.componentPtr = componentPtr;
+        PS_PROFILE_SPAN("SpecFile::UpdateSpecItem");
+        auto r = m_file.ReadRecordAt(id);
+        r.componentId = componentId;
         r.qty = qty;
-        WriteRecordAt(offset, r);
+        m_file.WriteRecordAt(id, r);
         m_file.Flush();
     }
 
-    std::uint32_t SpecFile::RebuildSpecLinks(std::uint32_t firstSpecPtr)
+    RecordId SpecFile::RebuildSpecLinks(RecordId firstSpecId)
     {
-        if (firstSpecPtr == NullPtr) return NullPtr;
+        PS_PROFILE_SPAN("SpecFile::RebuildSpecLinks");
+        if (firstSpecId == NullId) return NullId;
 
-        std::vector<SpecRecord> chain;
-        std::uint32_t cur = firstSpecPtr;
-        while (cur != NullPtr)
-        {
-            auto rec = ReadRecordAt(cur);
-            if (!rec.deleted) chain.push_back(rec);
-            cur = rec.nextPtr;
-        }
+        std::vector<RecordId> chain;
+        for (const auto& rec : Chain(firstSpecId))
+            if (!rec.deleted) chain.push_back(rec.id);
 
+        SpecRecord r;
         for (std::size_t i = 0; i < chain.size(); i++)
         {
-            auto next = (i + 1 < chain.size()) ? chain[i + 1].fileOffset : NullPtr;
-            UpdateNext(chain[i].fileOffset, static_cast<std::uint32_t>(next));
+            m_file.ReadRecordInto(chain[i], r);
+            r.nextId = (i + 1 < chain.size()) ? chain[i + 1] : NullId;
+            m_file.WriteRecordAt(chain[i], r);
         }
+        m_file.Flush();
 
-        return chain.empty() ? NullPtr : chain.front().fileOffset;
+        return chain.empty() ? NullId : chain.front();
     }
 
-    bool SpecFile::HasActiveReferenceToComponent(std::uint32_t componentPtr)
+    void SpecFile::TakeSnapshot() { m_snapshot.Take(m_file); }
+    void SpecFile::ClearSnapshot() { m_snapshot.Clear(); }
+    void SpecFile::RefreshSnapshot(RecordId id) { m_snapshot.Refresh(m_file, id); }
+    const SpecFile::Snapshot& SpecFile::GetSnapshot() const { return m_snapshot; }
+
+    std::vector<SpecFile::Snapshot::Change> SpecFile::ReloadChanged()
     {
-        for (const auto& r : ReadAllRecords())
-            if (!r.deleted && r.componentPtr == componentPtr) return true;
-        return false;
+        PS_PROFILE_SPAN("SpecFile::ReloadChanged");
+        m_file.Flush();
+        m_file.Reload();
+        return m_snapshot.Update(m_file);
     }
 }
@@ -1,44 +1,58 @@
 #pragma once
 #include <string>
 #include <vector>
-#include "../core/BinaryIO.h"
 #include "../domain/Models.h"
+#include "RecordFile.h"
+#include "RecordLayout.h"
+#include "RecordSnapshot.h"
 
 namespace ps
 {
     class SpecFile final
     {
     public:
-        void Create(const std::string& prsPath);
-        void Open(const std::string& prsPath);
+        using Storage = RecordFile<SpecFileLayout>;
+        using RecordRange = Storage::RecordRange;
+        using ChainRange = Storage::ChainRange;
+        using Snapshot = RecordSnapshot<SpecFileLayout>;
+
+        void Create(const std::string& prsPath, StorageBackend backend = DefaultStorageBackend);
+        void Open(const std::string& prsPath, StorageBackend backend = DefaultStorageBackend);
         void Close();
         bool IsOpen() const;
+        std::uint64_t RecordCount() const;
 
-        std::vector<SpecRecord> ReadAllRecords();
-        SpecRecord ReadRecordAt(std::uint32_t offset);
-
-        std::uint32_t AddSpecItem(std::uint32_t componentPtr, std::uint16_t qty);
+        // общий кэш страниц; задаётся до Create/Open
+        void UseCache(PageCache* cache);
 
-        void MarkDeleted(std::uint32_t offset, bool deleted);
-        void UpdateNext(std::uint32_t offset, std::uint32_t nextPtr);
-        void UpdateSpecItem(std::uint32_t offset, std::uint32_t componentPtr, std::uint16_t qty);
+        // все записи файла в физическом порядке, включая удалённые
+        RecordRange Records();
+        // цепочка спецификации, начиная с firstSpecId (включая удалённые звенья)
+        ChainRange Chain(RecordId firstSpecId);
 
-        std::uint32_t RebuildSpecLinks(std::uint32_t firstSpecPtr);
+        SpecRecord ReadRecordAt(RecordId id);
+        void ReadRecordInto(RecordId id, SpecRecord& rec);
 
-        bool HasActiveReferenceToComponent(std::uint32_t componentPtr);
+        RecordId AddSpecItem(RecordId componentId, std::uint16_t qty);
 
-    private:
-        static constexpr std::uint32_t NullPtr = 1;
+        void MarkDeleted(RecordId id, bool deleted);
+        void UpdateNext(RecordId id, RecordId nextId);
+        void UpdateSpecItem(RecordId id, RecordId componentId, std::uint16_t qty);
 
-        std::string m_prsPath;
-        BinaryFile m_file;
+        RecordId RebuildSpecLinks(RecordId firstSpecId);
 
-        std::uint64_t HeaderSize() const;
+        // Снимок записей для сверки с изменениями другого процесса
+        // (см. CatalogService::PollExternalChanges); Open/Create/Close его сбрасывают.
+        void TakeSnapshot();
+        void ClearSnapshot();
+        void RefreshSnapshot(RecordId id);
+        const Snapshot& GetSnapshot() const;
+        // перечитать файл с диска и вернуть записи, изменившиеся со времени снимка
+        std::vector<Snapshot::Change> ReloadChanged();
 
-        void WriteHeader(std::uint32_t headPtr, std::uint32_t freePtr);
-        void ReadHeader(std::uint32_t& headPtr, std::uint32_t& freePtr);
-
-        void WriteRecordAt(std::uint32_t offset, const SpecRecord& rec);
-        std::uint32_t AppendRecord(const SpecRecord& rec);
+    private:
+        std::string m_prsPath;
+        Storage m_file{ OperationCounter::SpecReads, OperationCounter::SpecWrites };
+        Snapshot m_snapshot;
     };
 }
@@ -0,0 +1,241 @@
+#include "TrigramIndex.h"
+#include "../domain/Collation.h"
+#include <algorithm>
+
+namespace ps
+{
+    static constexpr char32_t Boundary = 0; // граничный символ: в именах не встречается
+
+    static std::uint64_t Gram(char32_t a, char32_t b, char32_t c)
+    {
+        // символ помещается в 21 бит
+        return (static_cast<std::uint64_t>(a) << 42) | (static_cast<std::uint64_t>(b) << 21) | c;
+    }
+
+    static std::vector<std::uint64_t> Unique(std::vector<std::uint64_t> grams)
+    {
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+    // все триграммы имени вместе с граничными
+    static std::vector<std::uint64_t> PaddedGrams(const std::u32string& s)
+    {
+        std::u32string padded;
+        padded.reserve(s.size() + 4);
+        padded.append(2, Boundary);
+        padded += s;
+        padded.append(2, Boundary);
+
+        std::vector<std::uint64_t> grams;
+        for (std::size_t i = 0; i + 3 <= padded.size(); i++) grams.push_back(Gram(padded[i], padded[i + 1], padded[i + 2]));
+        return Unique(std::move(grams));
+    }
+
+    // триграммы внутри фрагмента: они есть у любого имени, содержащего фрагмент
+    static std::vector<std::uint64_t> InnerGrams(const std::u32string& s)
+    {
+        std::vector<std::uint64_t> grams;
+        for (std::size_t i = 0; i + 3 <= s.size(); i++) grams.push_back(Gram(s[i], s[i + 1], s[i + 2]));
+        return Unique(std::move(grams));
+    }
+
+    // расстояние Левенштейна, если оно не больше limit; иначе limit + 1
+    static std::size_t BoundedDistance(const std::u32string& a, const std::u32string& b, std::size_t limit)
+    {
+        const auto n = a.size();
+        const auto m = b.size();
+        if ((n > m ? n - m : m - n) > limit) return limit + 1;
+
+        std::vector<std::size_t> prev(m + 1);
+        std::vector<std::size_t> cur(m + 1);
+        for (std::size_t j = 0; j <= m; j++) prev[j] = j;
+
+        for (std::size_t i = 1; i <= n; i++)
+        {
+            cur[0] = i;
+            std::size_t rowMin = cur[0];
+            for (std::size_t j = 1; j <= m; j++)
+            {
+                const auto subst = prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                cur[j] = std::min({ prev[j] + 1, cur[j - 1] + 1, subst });
+                rowMin = std::min(rowMin, cur[j]);
+            }
+            if (rowMin > limit) return limit + 1;
+            std::swap(prev, cur);
+        }
+        return std::min(prev[m], limit + 1);
+    }
+
+    void TrigramIndex::Clear()
+    {
+        m_names.clear();
+        m_folded.clear();
+        m_free.clear();
+        m_slots.clear();
+        m_postings.clear();
+    }
+
+    void TrigramIndex::Add(const std::string& name)
+    {
+        if (name.empty() || m_slots.count(name) != 0) return;
+
+        Slot slot;
+        if (!m_free.empty())
+        {
+            slot = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            slot = static_cast<Slot>(m_names.size());
+            m_names.emplace_back();
+            m_folded.emplace_back();
+        }
+
+        m_names[slot] = name;
+        m_folded[slot] = FoldCase(name);
+        m_slots.emplace(name, slot);
+
+        for (const auto g : PaddedGrams(m_folded[slot]))
+        {
+            auto& list = m_postings[g];
+            if (list.empty() || list.back() < slot) list.push_back(slot);
+            else list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+        }
+    }
+
+    void TrigramIndex::Remove(const std::string& name)
+    {
+        const auto it = m_slots.find(name);
+        if (it == m_slots.end()) return;
+        const auto slot = it->second;
+
+        for (const auto g : PaddedGrams(m_folded[slot]))
+        {
+            const auto p = m_postings.find(g);
+            if (p == m_postings.end()) continue;
+
+            auto& list = p->second;
+            const auto pos = std::lower_bound(list.begin(), list.end(), slot);
+            if (pos != list.end() && *pos == slot) list.erase(pos);
+            if (list.empty()) m_postings.erase(p);
+        }
+
+        m_names[slot].clear();
+        m_folded[slot].clear();
+        m_free.push_back(slot);
+        m_slots.erase(it);
+    }
+
+    std::size_t TrigramIndex::Size() const { return m_slots.size(); }
+
+    // списки для всех триграмм, короткие первыми; пусто, если какой-то триграммы нет ни у кого
+    std::vector<const std::vector<TrigramIndex::Slot>*> TrigramIndex::Postings(const std::vector<std::uint64_t>& grams) const
+    {
+        std::vector<const std::vector<Slot>*> lists;
+        for (const auto g : grams)
+        {
+            const auto p = m_postings.find(g);
+            if (p == m_postings.end()) return {};
+            lists.push_back(&p->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+        return lists;
+    }
+
+    std::vector<TrigramIndex::Match> TrigramIndex::Containing(std::string_view fragment, std::size_t limit) const
+    {
+        std::vector<Match> out;
+        const auto f = FoldCase(fragment);
+        if (f.empty() || limit == 0) return out;
+
+        // ключ сортировки считается только у найденных имён
+        std::vector<std::pair<std::string, Slot>> hits;
+        auto check = [&](Slot slot)
+        {
+            if (!m_names[slot].empty() && m_folded[slot].find(f) != std::u32string::npos)
+                hits.emplace_back(CollationKey(m_names[slot]), slot);
+        };
+
+        if (f.size() < 3)
+        {
+            // фрагмент короче триграммы: индекс не сужает поиск
+            for (Slot slot = 0; slot < m_names.size(); slot++) check(slot);
+        }
+        else
+        {
+            const auto lists = Postings(InnerGrams(f));
+            if (lists.empty()) return out;
+
+            // пересечение: кандидаты из самого короткого списка ищутся в остальных;
+            // совпадение триграмм ещё не означает подстроку, поэтому проверяется само имя
+            for (const auto slot : *lists.front())
+            {
+                bool inAll = true;
+                for (std::size_t i = 1; i < lists.size() && inAll; i++)
+                    inAll = std::binary_search(lists[i]->begin(), lists[i]->end(), slot);
+                if (inAll) check(slot);
+            }
+        }
+
+        // слоты идут в порядке добавления: limit отсекается после сортировки по алфавиту
+        const auto kept = std::min(limit, hits.size());
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(kept), hits.end());
+        for (std::size_t i = 0; i < kept; i++) out.push_back({ m_names[hits[i].second], 0 });
+        return out;
+    }
+
+    std::vector<TrigramIndex::Match> TrigramIndex::Similar(std::string_view text, std::size_t maxEdits, std::size_t limit) const
+    {
+        std::vector<Match> out;
+        const auto q = FoldCase(text);
+        if (q.empty() || limit == 0) return out;
+
+        auto check = [&](Slot slot)
+        {
+            if (m_names[slot].empty()) return;
+            const auto d = BoundedDistance(q, m_folded[slot], maxEdits);
+            if (d <= maxEdits) out.push_back({ m_names[slot], d });
+        };
+
+        const auto grams = PaddedGrams(q);
+        if (grams.size() <= 3 * maxEdits)
+        {
+            // образец слишком короткий, чтобы триграммы что-то отсекли
+            for (Slot slot = 0; slot < m_names.size(); slot++) check(slot);
+        }
+        else
+        {
+            // Имя в пределах maxEdits правок сохраняет все триграммы образца, кроме
+            // не более 3 * maxEdits, значит, содержит хотя бы одну из любых
+            // 3 * maxEdits + 1. Кандидаты берутся из самых коротких списков.
+            std::vector<const std::vector<Slot>*> lists;
+            for (const auto g : grams)
+            {
+                const auto p = m_postings.find(g);
+                lists.push_back(p == m_postings.end() ? nullptr : &p->second);
+            }
+            std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b)
+            {
+                return (a ? a->size() : 0) < (b ? b->size() : 0);
+            });
+
+            std::vector<Slot> candidates;
+            for (std::size_t i = 0; i <= 3 * maxEdits; i++)
+                if (lists[i]) candidates.insert(candidates.end(), lists[i]->begin(), lists[i]->end());
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            for (const auto slot : candidates) check(slot);
+        }
+
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b)
+        {
+            return a.distance != b.distance ? a.distance < b.distance : a.name < b.name;
+        });
+        if (out.size() > limit) out.resize(limit);
+        return out;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ps
+{
+    // Инвертированный индекс триграмм по именам (в памяти).
+    //
+    // Имя без учёта регистра (FoldCase) дополняется двумя граничными символами
+    // с каждой стороны, и каждая тройка подряд идущих символов указывает на
+    // отсортированный список имён, где она встречается. Поиск подстроки
+    // пересекает списки триграмм образца; поиск с опечатками берёт кандидатов
+    // из самых редких триграмм образца (каждая правка портит не больше трёх
+    // триграмм) и проверяет их расстоянием Левенштейна.
+    // Результат — имена; номера записей по ним даёт словарь имён.
+    class TrigramIndex final
+    {
+    public:
+        struct Match
+        {
+            std::string name;
+            std::size_t distance = 0; // число правок; для подстроки 0
+        };
+
+        void Clear();
+        void Add(const std::string& name);
+        void Remove(const std::string& name);
+        std::size_t Size() const;
+
+        // не более limit первых по алфавиту имён, содержащих fragment без учёта регистра
+        std::vector<Match> Containing(std::string_view fragment, std::size_t limit) const;
+        // имена не дальше maxEdits правок от text (без учёта регистра), ближайшие первыми
+        std::vector<Match> Similar(std::string_view text, std::size_t maxEdits, std::size_t limit) const;
+
+    private:
+        using Slot = std::uint32_t;
+
+        std::vector<std::string> m_names;       // по номеру слота; пустая строка — свободный слот
+        std::vector<std::u32string> m_folded;
+        std::vector<Slot> m_free;
+        std::unordered_map<std::string, Slot> m_slots;
+        std::unordered_map<std::uint64_t, std::vector<Slot>> m_postings; // отсортированы
+
+        std::vector<const std::vector<Slot>*> Postings(const std::vector<std::uint64_t>& grams) const;
+    };
+}
@@ -1,22 +1,57 @@
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "core/ConsoleUtf8.h"
 #include "core/Errors.h"
+#include "core/Profiling.h"
 #include "core/UtfConv.h"
 #include "domain/Parsing.h"
 #include "services/CatalogService.h"
 #include "services/CommandRegistry.h"
+#include "services/CommandStats.h"
+#include "services/CommandTrace.h"
 #include "services/Commands.h"
 
 using namespace ps;
 
-int main()
+// ps_console [--trace файл]: с --trace команды, переданные обработчикам,
+// записываются в файл для воспроизведения в ps_replay. Профиль с начала
+// работы — PS_PROFILE=файл.json в окружении (см. core/Profiling.h).
+static std::unique_ptr<CommandTraceWriter> OpenTraceFromArgs(int argc, char** argv)
+{
+    std::unique_ptr<CommandTraceWriter> trace;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string key = argv[i];
+        if (key == "--trace" && i + 1 < argc)
+            trace = std::make_unique<CommandTraceWriter>(argv[++i]);
+        else
+            throw ValidationException("Неизвестный параметр " + key + ". Использование: ps_console [--trace файл].");
+    }
+    return trace;
+}
+
+int main(int argc, char** argv)
 {
     try
     {
         ps::ConfigureConsoleForCyrillic();
 
+        const auto trace = OpenTraceFromArgs(argc, argv);
+        try
+        {
+            StartProfilingFromEnvironment();
+        }
+        catch (const PsException& ex)
+        {
+            // профиль не обязателен: работа продолжается без него
+            ps::ConsoleWriteErrW(L"PS_PROFILE: ");
+            ps::ConsoleWriteErrW(Utf8ToWide(ex.what()));
+            ps::ConsoleWriteErrW(L"\n");
+        }
+
         CatalogService service;
         CommandRegistry registry;
         for (auto& cmd : CreateDefaultCommands())
@@ -48,7 +83,13 @@ int main()
                 continue;
             }
 
+            if (trace) trace->Record(parsed);
+
+            const auto countersBefore = ReadOperationCounters();
+            const auto started = std::chrono::steady_clock::now();
             auto res = handler->Execute(parsed, service);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+            ProcessCommandStats().Record(handler->Name(), static_cast<std::uint64_t>(elapsed.count()), ReadOperationCounters() - countersBefore);
 
             if (!res.error.empty())
             {
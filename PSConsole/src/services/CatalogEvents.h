@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "../domain/Models.h"
+
+namespace ps
+{
+    // Изменение каталога, о котором CatalogService сообщает подписчикам
+    // (см. CatalogService::Subscribe). Событие приходит после того, как изменение
+    // записано, в том потоке, где выполнялась операция.
+    struct CatalogEvent
+    {
+        enum class Kind : std::uint8_t
+        {
+            ComponentAdded,    // componentId
+            ComponentChanged,  // componentId: новое имя и/или тип
+            ComponentDeleted,  // componentId
+            ComponentRestored, // componentId
+            LinkAdded,         // ownerId, componentId, specId, qty (и восстановленная связь)
+            LinkUpdated,       // ownerId, componentId, specId, qty; previousComponentId — прежнее комплектующее
+            LinkRemoved,       // ownerId, componentId, specId
+            // каталог открыт, закрыт или изменён целиком (Truncate, RestoreAll):
+            // прежние номера записей больше не действительны
+            Reloaded
+        };
+
+        Kind kind = Kind::Reloaded;
+        RecordId componentId = NullId;
+        RecordId ownerId = NullId;
+        RecordId specId = NullId;
+        RecordId previousComponentId = NullId;
+        std::uint16_t qty = 0;
+    };
+
+    using CatalogListener = std::function<void(const CatalogEvent&)>;
+}
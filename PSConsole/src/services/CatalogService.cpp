@@ -1,7 +1,9 @@
 #include "CatalogService.h"
 #include "../core/Errors.h"
+#include "../core/Profiling.h"
+#include "../domain/Collation.h"
+#include "../infra/FormatUpgrade.h"
 #include <algorithm>
-#include <cstdio>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,6 +18,12 @@ namespace ps
         return s.substr(b, e - b + 1);
     }
 
+    CatalogService::CatalogService()
+    {
+        m_products.UseCache(&m_cache);
+        m_specs.UseCache(&m_cache);
+    }
+
     bool CatalogService::HasOpenFiles() const { return m_products.IsOpen() && m_specs.IsOpen(); }
 
     std::string CatalogService::EnsureExt(const std::string& base, const std::string& ext)
@@ -29,37 +37,250 @@ namespace ps
         if (!HasOpenFiles()) throw ValidationException("Файлы не открыты. Выполните Create или Open.");
     }
 
-    void CatalogService::Create(const std::string& baseName, std::uint16_t maxNameLen, const std::optional<std::string>& prsNameOpt)
+    void CatalogService::SetProgress(Progress* progress) { m_progress = progress; }
+
+    std::size_t CatalogService::Subscribe(CatalogListener listener)
+    {
+        const auto id = m_nextSubscription++;
+        m_listeners.emplace_back(id, std::move(listener));
+        return id;
+    }
+
+    void CatalogService::Unsubscribe(std::size_t subscription)
+    {
+        m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+                                         [&](const auto& l) { return l.first == subscription; }),
+                          m_listeners.end());
+    }
+
+    void CatalogService::Notify(const CatalogEvent& event)
+    {
+        Remember(event);
+        for (const auto& l : m_listeners) l.second(event);
+    }
+
+    void CatalogService::Notify(CatalogEvent::Kind kind, RecordId componentId)
+    {
+        CatalogEvent event;
+        event.kind = kind;
+        event.componentId = componentId;
+        Notify(event);
+    }
+
+    void CatalogService::WatchExternalChanges(bool enabled)
+    {
+        m_watchExternal = enabled;
+        Remember(CatalogEvent{}); // снимок берётся или освобождается, как после Open/Close
+    }
+
+    void CatalogService::Remember(const CatalogEvent& event)
+    {
+        TrackReferencesFromHidden(event);
+        if (event.kind == CatalogEvent::Kind::Reloaded)
+        {
+            if (m_watchExternal && HasOpenFiles())
+            {
+                m_products.TakeSnapshot();
+                m_specs.TakeSnapshot();
+            }
+            else
+            {
+                m_products.ClearSnapshot();
+                m_specs.ClearSnapshot();
+            }
+            return;
+        }
+
+        if (!m_watchExternal) return;
+        m_products.RefreshSnapshot(event.componentId);
+        m_products.RefreshSnapshot(event.ownerId);
+        m_specs.RefreshSnapshot(event.specId);
+    }
+
+    bool CatalogService::PollExternalChanges()
+    {
+        PS_PROFILE_SPAN("CatalogService::PollExternalChanges");
+        if (!m_watchExternal || !HasOpenFiles() || !m_products.ChangedOnDisk()) return false;
+
+        if (m_products.ReplacedOnDisk())
+        {
+            const auto& prd = m_products.PrdPath();
+            Open(prd.substr(0, prd.size() - 4), m_backend);
+            return true;
+        }
+
+        const auto components = m_products.ReloadChanged();
+        const auto specs = m_specs.ReloadChanged();
+
+        // события описывают уже прочитанное состояние: счёт ссылок от удалённых
+        // строится по нему заново, а не правится по каждому событию
+        m_refsFromHidden.reset();
+        m_applyingExternal = true;
+        struct ExternalBatch
+        {
+            bool& flag;
+            ~ExternalBatch() { flag = false; }
+        } batch{ m_applyingExternal };
+
+        // сначала компоненты: новые связи могут ссылаться на только что добавленные
+        for (const auto& c : components)
+        {
+            const auto now = m_products.ReadRecordAt(c.id);
+            if (!c.before)
+            {
+                if (!now.deleted) Notify(CatalogEvent::Kind::ComponentAdded, c.id);
+            }
+            else if (c.before->deleted != now.deleted)
+            {
+                Notify(now.deleted ? CatalogEvent::Kind::ComponentDeleted : CatalogEvent::Kind::ComponentRestored, c.id);
+            }
+            else if (!now.deleted && (c.before->name != now.name || c.before->type != now.type))
+            {
+                Notify(CatalogEvent::Kind::ComponentChanged, c.id);
+            }
+        }
+
+        if (specs.empty()) return true;
+
+        // удалённые звенья остаются в цепочке: владельца видно и у снятой связи
+        const auto owners = SnapshotSpecOwners();
+        for (const auto& c : specs)
+        {
+            const auto now = m_specs.GetSnapshot().At(c.id);
+            if (owners[c.id] == NullId) continue;
+
+            CatalogEvent event;
+            event.ownerId = owners[c.id];
+            event.componentId = now.componentId;
+            event.specId = c.id;
+            event.qty = now.qty;
+
+            const bool wasActive = c.before && !c.before->deleted;
+            if (!wasActive && !now.deleted)
+            {
+                event.kind = CatalogEvent::Kind::LinkAdded;
+            }
+            else if (wasActive && now.deleted)
+            {
+                event.kind = CatalogEvent::Kind::LinkRemoved;
+                event.componentId = c.before->componentId;
+            }
+            else if (wasActive && (c.before->componentId != now.componentId || c.before->qty != now.qty))
+            {
+                event.kind = CatalogEvent::Kind::LinkUpdated;
+                event.previousComponentId = c.before->componentId;
+            }
+            else
+            {
+                continue; // изменились только ссылки цепочки
+            }
+            Notify(event);
+        }
+        return true;
+    }
+
+    std::vector<RecordId> CatalogService::SnapshotSpecOwners() const
     {
+        const auto& products = m_products.GetSnapshot();
+        const auto& specs = m_specs.GetSnapshot();
+
+        std::vector<RecordId> owners(specs.RecordCount() + 1, NullId);
+        for (RecordId id = 1; id <= products.RecordCount(); id++)
+        {
+            // повторный заход в звено означает испорченную цепочку: дальше не идём
+            for (auto s = products.At(id).firstSpecId; s != NullId && s <= specs.RecordCount() && owners[s] == NullId; s = specs.At(s).nextId)
+                owners[s] = id;
+        }
+        return owners;
+    }
+
+    void CatalogService::Step(std::uint64_t done, std::uint64_t total)
+    {
+        // наблюдатель опрашивается раз в StepBatch шагов, чтобы не замедлять проходы по записям
+        constexpr std::uint64_t StepBatch = 1024;
+        if (m_progress == nullptr || (done % StepBatch != 0 && done != total)) return;
+
+        m_progress->Report(done, total);
+        if (m_progress->Cancelled()) throw OperationCancelled();
+    }
+
+    void CatalogService::Create(const std::string& baseName, std::uint16_t maxNameLen, const std::optional<std::string>& prsNameOpt,
+                                StorageBackend backend)
+    {
+        PS_PROFILE_SPAN("CatalogService::Create");
         auto prd = EnsureExt(baseName, ".prd");
         auto prs = prsNameOpt.has_value() ? EnsureExt(*prsNameOpt, ".prs") : EnsureExt(baseName, ".prs");
-        m_products.Create(prd, maxNameLen, prs);
-        m_specs.Create(prs);
+        m_backend = backend;
+        m_products.Create(prd, maxNameLen, prs, backend);
+        m_specs.Create(prs, backend);
+        Notify(CatalogEvent::Kind::Reloaded, NullId);
     }
 
-    void CatalogService::Open(const std::string& baseName)
+    void CatalogService::Open(const std::string& baseName, StorageBackend backend)
     {
+        PS_PROFILE_SPAN("CatalogService::Open");
         auto prd = EnsureExt(baseName, ".prd");
-        m_products.Open(prd);
+        m_backend = backend;
+        UpgradeLegacyCatalog(prd, EnsureExt(baseName, ".prs"), backend);
+        m_products.Open(prd, backend);
         auto prs = m_products.PrsPath();
         if (prs.empty()) prs = EnsureExt(baseName, ".prs");
-        m_specs.Open(prs);
+        m_specs.Open(prs, backend);
+
+        if (!m_products.HasReferenceCounts())
+        {
+            try
+            {
+                RecountReferences();
+            }
+            catch (const OperationCancelled&)
+            {
+                // счётчики не записаны: каталог остаётся в прежнем виде и закрывается
+                Close();
+                throw;
+            }
+        }
+
+        Notify(CatalogEvent::Kind::Reloaded, NullId);
+    }
+
+    // Каталог без счётчиков ссылок: один проход по .prs заполняет их все.
+    void CatalogService::RecountReferences()
+    {
+        PS_PROFILE_SPAN("CatalogService::RecountReferences");
+        std::vector<std::uint32_t> counts(m_products.Header().recordCount);
+        const auto total = m_specs.RecordCount();
+        std::uint64_t done = 0;
+        for (const auto& s : m_specs.Records())
+        {
+            Step(++done, total);
+            if (!s.deleted && s.componentId != NullId && s.componentId <= counts.size()) counts[s.componentId - 1]++;
+        }
+
+        m_products.StoreReferenceCounts(counts);
     }
 
     void CatalogService::Close()
     {
+        PS_PROFILE_SPAN("CatalogService::Close");
+        const bool wasOpen = HasOpenFiles();
         m_products.Close();
         m_specs.Close();
+        if (wasOpen) Notify(CatalogEvent::Kind::Reloaded, NullId);
     }
 
-    void CatalogService::InputComponent(const std::string& name, ComponentType type)
+    RecordId CatalogService::InputComponent(const std::string& name, ComponentType type)
     {
+        PS_PROFILE_SPAN("CatalogService::InputComponent");
         EnsureOpen();
-        m_products.AddComponent(name, type);
+        const auto id = m_products.AddComponent(name, type).id;
+        Notify(CatalogEvent::Kind::ComponentAdded, id);
+        return id;
     }
 
     void CatalogService::UpdateComponent(const std::string& oldName, const std::string& newName, ComponentType newType)
     {
+        PS_PROFILE_SPAN("CatalogService::UpdateComponent");
         EnsureOpen();
 
         auto oldOpt = m_products.FindActiveByName(oldName);
@@ -73,27 +294,35 @@ namespace ps
         if (TrimGuiName(oldRec.name) != nm && m_products.FindActiveByName(nm).has_value())
             throw ValidationException("Дублирование имен компонентов.");
 
-        m_products.UpdateComponent(oldRec.fileOffset, nm, newType);
+        // состав детали не показывается и не правится: её связи пропали бы из дерева
+        const bool detailChanges = (oldRec.type == ComponentType::Detail) != (newType == ComponentType::Detail);
+        bool hasLinks = false;
+        if (detailChanges)
+            for (const auto& spec : m_specs.Chain(oldRec.firstSpecId))
+                hasLinks = hasLinks || !spec.deleted;
+        if (hasLinks && newType == ComponentType::Detail)
+            throw ValidationException("Нельзя сделать деталью компонент с непустой спецификацией.");
+
+        m_products.UpdateComponent(oldRec.id, nm, newType);
         m_products.RebuildAlphabeticalLinks();
+        // деталь из каталога прежней версии со связями стала узлом или изделием
+        if (hasLinks) m_refsFromHidden.reset();
+        Notify(CatalogEvent::Kind::ComponentChanged, oldRec.id);
     }
 
-    std::vector<SpecRecord> CatalogService::ReadSpecChain(std::uint32_t firstSpecPtr)
+    std::vector<RecordId> CatalogService::ReadChildIds(RecordId firstSpecId)
     {
-        std::vector<SpecRecord> out;
-        std::uint32_t cur = firstSpecPtr;
-        while (cur != NullPtr)
-        {
-            auto r = m_specs.ReadRecordAt(cur);
-            if (!r.deleted) out.push_back(r);
-            cur = r.nextPtr;
-        }
+        std::vector<RecordId> out;
+        for (const auto& r : m_specs.Chain(firstSpecId))
+            if (!r.deleted) out.push_back(r.componentId);
         return out;
     }
 
-    bool CatalogService::WouldCreateCycle(std::uint32_t ownerPtr, std::uint32_t partPtr)
+    bool CatalogService::WouldCreateCycle(RecordId ownerId, RecordId partId)
     {
-        std::vector<std::uint32_t> stack{ partPtr };
-        std::unordered_set<std::uint32_t> visited;
+        PS_PROFILE_SPAN("CatalogService::WouldCreateCycle");
+        std::vector<RecordId> stack{ partId };
+        std::unordered_set<RecordId> visited;
 
         while (!stack.empty())
         {
@@ -101,13 +330,13 @@ namespace ps
             stack.pop_back();
 
             if (!visited.insert(current).second) continue;
-            if (current == ownerPtr) return true;
+            if (current == ownerId) return true;
 
             auto component = m_products.ReadRecordAt(current);
             if (component.deleted || component.type == ComponentType::Detail) continue;
 
-            for (const auto& child : ReadSpecChain(component.firstSpecPtr))
-                stack.push_back(child.componentPtr);
+            for (const auto& child : m_specs.Chain(component.firstSpecId))
+                if (!child.deleted) stack.push_back(child.componentId);
         }
 
         return false;
@@ -115,6 +344,7 @@ namespace ps
 
     void CatalogService::InputSpecItem(const std::string& ownerName, const std::string& partName, std::uint16_t qty)
     {
+        PS_PROFILE_SPAN("CatalogService::InputSpecItem");
         EnsureOpen();
 
         auto ownerOpt = m_products.FindActiveByName(ownerName);
@@ -127,38 +357,35 @@ namespace ps
         auto part = *partOpt;
 
         if (owner.type == ComponentType::Detail) throw ValidationException("Для детали нельзя добавлять спецификацию.");
-        if (owner.fileOffset == part.fileOffset) throw ValidationException("Компонент не может входить в собственную спецификацию.");
-        if (WouldCreateCycle(owner.fileOffset, part.fileOffset))
+        if (owner.id == part.id) throw ValidationException("Компонент не может входить в собственную спецификацию.");
+        if (WouldCreateCycle(owner.id, part.id))
             throw ValidationException("Добавление связи создаёт цикл в структуре.");
 
-        for (const auto& spec : ReadSpecChain(owner.firstSpecPtr))
+        RecordId last = NullId;
+        for (const auto& spec : m_specs.Chain(owner.firstSpecId))
         {
-            if (spec.componentPtr == part.fileOffset)
+            if (!spec.deleted && spec.componentId == part.id)
                 throw ValidationException("Такая связь уже указана в спецификации.");
+            last = spec.id;
         }
 
-        auto newSpecOff = m_specs.AddSpecItem(part.fileOffset, qty);
-        if (owner.firstSpecPtr == NullPtr)
-        {
-            m_products.UpdatePointers(owner.fileOffset, newSpecOff, owner.nextPtr);
-            return;
-        }
-
-        std::uint32_t cur = owner.firstSpecPtr;
-        while (true)
-        {
-            auto r = m_specs.ReadRecordAt(cur);
-            if (r.nextPtr == NullPtr)
-            {
-                m_specs.UpdateNext(cur, newSpecOff);
-                break;
-            }
-            cur = r.nextPtr;
-        }
+        auto newSpecId = m_specs.AddSpecItem(part.id, qty);
+        m_products.AdjustReferences(part.id, +1);
+        if (last == NullId) m_products.UpdatePointers(owner.id, newSpecId, owner.nextId);
+        else m_specs.UpdateNext(last, newSpecId);
+
+        CatalogEvent event;
+        event.kind = CatalogEvent::Kind::LinkAdded;
+        event.ownerId = owner.id;
+        event.componentId = part.id;
+        event.specId = newSpecId;
+        event.qty = qty;
+        Notify(event);
     }
 
     void CatalogService::UpdateSpecItem(const std::string& ownerName, const std::string& oldPartName, const std::string& newPartName, std::uint16_t qty)
     {
+        PS_PROFILE_SPAN("CatalogService::UpdateSpecItem");
         EnsureOpen();
 
         auto ownerOpt = m_products.FindActiveByName(ownerName);
@@ -171,51 +398,71 @@ namespace ps
         auto newPart = *newPartOpt;
 
         if (owner.type == ComponentType::Detail) throw ValidationException("У детали нет спецификации.");
-        if (owner.fileOffset == newPart.fileOffset) throw ValidationException("Компонент не может входить в собственную спецификацию.");
-        if (WouldCreateCycle(owner.fileOffset, newPart.fileOffset))
+        if (owner.id == newPart.id) throw ValidationException("Компонент не может входить в собственную спецификацию.");
+        if (WouldCreateCycle(owner.id, newPart.id))
             throw ValidationException("Добавление связи создаёт цикл в структуре.");
 
-        std::uint32_t targetSpecOffset = NullPtr;
-        std::uint32_t cur = owner.firstSpecPtr;
-        while (cur != NullPtr)
+        RecordId targetSpecId = NullId;
+        RecordId oldPartId = NullId;
+        ComponentRecord part;
+        for (const auto& spec : m_specs.Chain(owner.firstSpecId))
         {
-            auto spec = m_specs.ReadRecordAt(cur);
-            if (!spec.deleted)
+            if (spec.deleted) continue;
+
+            m_products.ReadRecordInto(spec.componentId, part);
+            if (part.name == oldPartName)
             {
-                auto part = m_products.ReadRecordAt(spec.componentPtr);
-                if (part.name == oldPartName)
-                {
-                    targetSpecOffset = spec.fileOffset;
-                }
-                else if (part.fileOffset == newPart.fileOffset)
-                {
-                    throw ValidationException("Такая связь уже указана в спецификации.");
-                }
+                targetSpecId = spec.id;
+                oldPartId = part.id;
+            }
+            else if (part.id == newPart.id)
+            {
+                throw ValidationException("Такая связь уже указана в спецификации.");
             }
-            cur = spec.nextPtr;
         }
 
-        if (targetSpecOffset == NullPtr)
+        if (targetSpecId == NullId)
             throw ValidationException("Комплектующее в спецификации не найдено.");
 
-        m_specs.UpdateSpecItem(targetSpecOffset, newPart.fileOffset, qty);
+        m_specs.UpdateSpecItem(targetSpecId, newPart.id, qty);
+        if (oldPartId != newPart.id)
+        {
+            m_products.AdjustReferences(oldPartId, -1);
+            m_products.AdjustReferences(newPart.id, +1);
+        }
+        else
+        {
+            m_products.NoteSpecChange();
+        }
+
+        CatalogEvent event;
+        event.kind = CatalogEvent::Kind::LinkUpdated;
+        event.ownerId = owner.id;
+        event.componentId = newPart.id;
+        event.previousComponentId = oldPartId;
+        event.specId = targetSpecId;
+        event.qty = qty;
+        Notify(event);
     }
 
     void CatalogService::DeleteComponent(const std::string& name)
     {
+        PS_PROFILE_SPAN("CatalogService::DeleteComponent");
         EnsureOpen();
         auto recOpt = m_products.FindActiveByName(name);
         if (!recOpt.has_value()) throw ValidationException("Компонент не найден.");
 
         auto rec = *recOpt;
-        if (m_specs.HasActiveReferenceToComponent(rec.fileOffset))
+        if (rec.refCount != 0)
             throw ValidationException("Невозможно удалить: на компонент есть ссылки в спецификациях других компонентов.");
 
-        m_products.MarkDeleted(rec.fileOffset, true);
+        m_products.MarkDeleted(rec.id, true);
+        Notify(CatalogEvent::Kind::ComponentDeleted, rec.id);
     }
 
     void CatalogService::DeleteSpecItem(const std::string& ownerName, const std::string& partName)
     {
+        PS_PROFILE_SPAN("CatalogService::DeleteSpecItem");
         EnsureOpen();
 
         auto ownerOpt = m_products.FindActiveByName(ownerName);
@@ -223,21 +470,27 @@ namespace ps
 
         auto owner = *ownerOpt;
         if (owner.type == ComponentType::Detail) throw ValidationException("У детали нет спецификации.");
-        if (owner.firstSpecPtr == NullPtr) throw ValidationException("Спецификация пуста.");
+        if (owner.firstSpecId == NullId) throw ValidationException("Спецификация пуста.");
 
-        std::uint32_t cur = owner.firstSpecPtr;
-        while (cur != NullPtr)
+        ComponentRecord comp;
+        for (const auto& sr : m_specs.Chain(owner.firstSpecId))
         {
-            auto sr = m_specs.ReadRecordAt(cur);
-            auto comp = m_products.ReadRecordAt(sr.componentPtr);
+            if (sr.deleted) continue;
 
-            if (!sr.deleted && comp.name == partName)
+            m_products.ReadRecordInto(sr.componentId, comp);
+            if (comp.name == partName)
             {
-                m_specs.MarkDeleted(sr.fileOffset, true);
+                m_specs.MarkDeleted(sr.id, true);
+                m_products.AdjustReferences(sr.componentId, -1);
+
+                CatalogEvent event;
+                event.kind = CatalogEvent::Kind::LinkRemoved;
+                event.ownerId = owner.id;
+                event.componentId = sr.componentId;
+                event.specId = sr.id;
+                Notify(event);
                 return;
             }
-
-            cur = sr.nextPtr;
         }
 
         throw ValidationException("Комплектующее в спецификации не найдено.");
@@ -245,48 +498,57 @@ namespace ps
 
     void CatalogService::RestoreAll()
     {
+        PS_PROFILE_SPAN("CatalogService::RestoreAll");
         EnsureOpen();
-        for (const auto& r : m_products.ReadAllRecords())
+        for (const auto& r : m_products.Records())
         {
-            if (r.deleted) m_products.MarkDeleted(r.fileOffset, false);
+            if (r.deleted) m_products.MarkDeleted(r.id, false);
         }
         m_products.RebuildAlphabeticalLinks();
 
-        std::unordered_set<std::uint32_t> visitedSpecOffsets;
-        for (const auto& component : m_products.ReadAllRecords())
+        std::unordered_set<RecordId> visitedSpecIds;
+        for (const auto& component : m_products.Records())
         {
-            std::uint32_t cur = component.firstSpecPtr;
-            while (cur != NullPtr)
+            for (const auto& spec : m_specs.Chain(component.firstSpecId))
             {
-                if (!visitedSpecOffsets.insert(cur).second) break;
+                if (!visitedSpecIds.insert(spec.id).second) break;
+                if (!spec.deleted) continue;
 
-                auto spec = m_specs.ReadRecordAt(cur);
-                if (spec.deleted) m_specs.MarkDeleted(spec.fileOffset, false);
-                cur = spec.nextPtr;
+                m_specs.MarkDeleted(spec.id, false);
+                m_products.AdjustReferences(spec.componentId, +1);
             }
         }
+
+        Notify(CatalogEvent::Kind::Reloaded, NullId);
     }
 
     void CatalogService::RestoreComponent(const std::string& name)
     {
+        PS_PROFILE_SPAN("CatalogService::RestoreComponent");
         EnsureOpen();
 
         bool found = false;
-        for (const auto& r : m_products.ReadAllRecords())
+        std::vector<RecordId> restored;
+        for (const auto& r : m_products.Records())
         {
             if (r.name == name)
             {
                 found = true;
-                if (r.deleted) m_products.MarkDeleted(r.fileOffset, false);
+                if (!r.deleted) continue;
+
+                m_products.MarkDeleted(r.id, false);
+                restored.push_back(r.id);
             }
         }
 
         if (!found) throw ValidationException("Компонент не найден.");
         m_products.RebuildAlphabeticalLinks();
+        for (const auto id : restored) Notify(CatalogEvent::Kind::ComponentRestored, id);
     }
 
     void CatalogService::RestoreSpecItem(const std::string& ownerName, const std::string& partName)
     {
+        PS_PROFILE_SPAN("CatalogService::RestoreSpecItem");
         EnsureOpen();
 
         auto ownerOpt = m_products.FindActiveByName(ownerName);
@@ -299,141 +561,302 @@ namespace ps
         auto part = *partOpt;
 
         if (owner.type == ComponentType::Detail) throw ValidationException("У детали нет спецификации.");
-        if (owner.fileOffset == part.fileOffset) throw ValidationException("Компонент не может входить в собственную спецификацию.");
-        if (WouldCreateCycle(owner.fileOffset, part.fileOffset))
+        if (owner.id == part.id) throw ValidationException("Компонент не может входить в собственную спецификацию.");
+        if (WouldCreateCycle(owner.id, part.id))
             throw ValidationException("Добавление связи создаёт цикл в структуре.");
 
-        std::uint32_t cur = owner.firstSpecPtr;
-        std::uint32_t deletedInChain = NullPtr;
-        while (cur != NullPtr)
+        RecordId deletedInChain = NullId;
+        RecordId last = NullId;
+        for (const auto& sr : m_specs.Chain(owner.firstSpecId))
         {
-            auto sr = m_specs.ReadRecordAt(cur);
-            if (sr.componentPtr == part.fileOffset)
+            if (sr.componentId == part.id)
             {
                 if (!sr.deleted)
                     throw ValidationException("Такая связь уже активна в спецификации.");
-                if (deletedInChain == NullPtr)
-                    deletedInChain = sr.fileOffset;
+                if (deletedInChain == NullId)
+                    deletedInChain = sr.id;
             }
 
-            cur = sr.nextPtr;
+            last = sr.id;
         }
 
-        if (deletedInChain != NullPtr)
+        CatalogEvent event;
+        event.kind = CatalogEvent::Kind::LinkAdded;
+        event.ownerId = owner.id;
+        event.componentId = part.id;
+
+        if (deletedInChain != NullId)
         {
             m_specs.MarkDeleted(deletedInChain, false);
+            m_products.AdjustReferences(part.id, +1);
+
+            event.specId = deletedInChain;
+            event.qty = m_specs.ReadRecordAt(deletedInChain).qty;
+            Notify(event);
             return;
         }
 
-        std::unordered_set<std::uint32_t> linkedSpecOffsets;
-        for (const auto& component : m_products.ReadAllRecords())
+        std::unordered_set<RecordId> linkedSpecIds;
+        for (const auto& component : m_products.Records())
         {
-            std::uint32_t specPtr = component.firstSpecPtr;
-            while (specPtr != NullPtr)
-            {
-                if (!linkedSpecOffsets.insert(specPtr).second) break;
-                auto sr = m_specs.ReadRecordAt(specPtr);
-                specPtr = sr.nextPtr;
-            }
+            for (const auto& sr : m_specs.Chain(component.firstSpecId))
+                if (!linkedSpecIds.insert(sr.id).second) break;
         }
 
-        std::uint32_t targetOffset = NullPtr;
-        for (const auto& sr : m_specs.ReadAllRecords())
+        RecordId targetId = NullId;
+        for (const auto& sr : m_specs.Records())
         {
-            if (!sr.deleted || sr.componentPtr != part.fileOffset)
+            if (!sr.deleted || sr.componentId != part.id)
                 continue;
-            if (linkedSpecOffsets.find(sr.fileOffset) != linkedSpecOffsets.end())
+            if (linkedSpecIds.find(sr.id) != linkedSpecIds.end())
                 continue;
 
-            if (targetOffset != NullPtr)
+            if (targetId != NullId)
                 throw ValidationException("Нельзя однозначно восстановить связь: найдено несколько удалённых записей.");
 
-            targetOffset = sr.fileOffset;
+            targetId = sr.id;
         }
 
-        if (targetOffset == NullPtr)
+        if (targetId == NullId)
             throw ValidationException("Удалённая связь в спецификации не найдена.");
 
-        m_specs.UpdateNext(targetOffset, NullPtr);
-        m_specs.MarkDeleted(targetOffset, false);
+        m_specs.UpdateNext(targetId, NullId);
+        m_specs.MarkDeleted(targetId, false);
+        m_products.AdjustReferences(part.id, +1);
 
-        if (owner.firstSpecPtr == NullPtr)
-        {
-            m_products.UpdatePointers(owner.fileOffset, targetOffset, owner.nextPtr);
-            return;
-        }
+        if (last == NullId) m_products.UpdatePointers(owner.id, targetId, owner.nextId);
+        else m_specs.UpdateNext(last, targetId);
 
-        std::uint32_t last = owner.firstSpecPtr;
-        while (true)
-        {
-            auto sr = m_specs.ReadRecordAt(last);
-            if (sr.nextPtr == NullPtr) break;
-            last = sr.nextPtr;
-        }
-        m_specs.UpdateNext(last, targetOffset);
+        event.specId = targetId;
+        event.qty = m_specs.ReadRecordAt(targetId).qty;
+        Notify(event);
     }
 
     std::vector<ComponentRecord> CatalogService::ListComponents()
     {
+        PS_PROFILE_SPAN("CatalogService::ListComponents");
         EnsureOpen();
 
         std::vector<ComponentRecord> out;
-        std::uint32_t cur = m_products.Header().headPtr;
-        while (cur != NullPtr)
-        {
-            auto r = m_products.ReadRecordAt(cur);
+        for (const auto& r : m_products.Alphabetical())
             if (!r.deleted) out.push_back(r);
-            cur = r.nextPtr;
-        }
         return out;
     }
 
-    std::vector<ComponentRecord> CatalogService::ListSpecificationRoots()
+    std::vector<RecordId> CatalogService::ListComponentIds()
     {
+        PS_PROFILE_SPAN("CatalogService::ListComponentIds");
         EnsureOpen();
 
-        auto components = ListComponents();
-        std::unordered_set<std::uint32_t> referenced;
+        const auto total = m_products.Header().recordCount;
+        std::uint64_t done = 0;
 
-        for (const auto& owner : components)
+        std::vector<RecordId> out;
+        for (const auto& r : m_products.Alphabetical())
         {
-            if (owner.type == ComponentType::Detail) continue;
-
-            for (const auto& spec : ReadSpecChain(owner.firstSpecPtr))
-                referenced.insert(spec.componentPtr);
+            Step(++done, total);
+            if (!r.deleted) out.push_back(r.id);
         }
+        return out;
+    }
 
+    ComponentRecord CatalogService::ReadComponent(RecordId id)
+    {
+        PS_PROFILE_SPAN("CatalogService::ReadComponent");
+        EnsureOpen();
+
+        if (id == NullId || id > m_products.Header().recordCount) throw ValidationException("Компонент не найден.");
+        return m_products.ReadRecordAt(id);
+    }
+
+    std::vector<ComponentRecord> CatalogService::ListComponentsByPrefix(const std::string& prefix, std::size_t limit)
+    {
+        PS_PROFILE_SPAN("CatalogService::ListComponentsByPrefix");
+        EnsureOpen();
+        return m_products.FindActiveByPrefix(prefix, limit);
+    }
+
+    std::vector<ComponentRecord> CatalogService::FindComponents(const std::string& text)
+    {
+        PS_PROFILE_SPAN("CatalogService::FindComponents");
+        EnsureOpen();
+
+        constexpr std::size_t MaxResults = 100;
+
+        auto nm = TrimGuiName(text);
+        if (nm.empty()) throw ValidationException("Пустая строка поиска.");
+
+        auto found = m_products.FindActiveContaining(nm, MaxResults);
+        if (!found.empty()) return found;
+
+        // одна опечатка на короткое имя, две — на длинное
+        const auto maxEdits = FoldCase(nm).size() <= 5 ? 1u : 2u;
+        return m_products.FindActiveSimilar(nm, maxEdits, MaxResults);
+    }
+
+    std::vector<ComponentRecord> CatalogService::SelectComponents(const ComponentQuery& query)
+    {
+        PS_PROFILE_SPAN("CatalogService::SelectComponents");
+        EnsureOpen();
+        return m_products.Select(query);
+    }
+
+    std::vector<ComponentRecord> CatalogService::ListSpecificationRoots()
+    {
+        PS_PROFILE_SPAN("CatalogService::ListSpecificationRoots");
         std::vector<ComponentRecord> roots;
-        for (const auto& component : components)
+        ListSpecificationRoots([&](const ComponentRecord& root) { roots.push_back(root); });
+        return roots;
+    }
+
+    void CatalogService::ListSpecificationRoots(const std::function<void(const ComponentRecord&)>& onRoot)
+    {
+        PS_PROFILE_SPAN("CatalogService::ListSpecificationRoots");
+        EnsureOpen();
+
+        const auto& fromHidden = ReferencesFromHidden();
+
+        // в алфавитном списке есть и удалённые, поэтому число шагов — все записи
+        const auto total = m_products.Header().recordCount;
+        std::uint64_t done = 0;
+        for (const auto& component : m_products.Alphabetical())
         {
+            Step(++done, total);
+            if (component.deleted) continue;
+
             if (component.type == ComponentType::Product)
             {
-                roots.push_back(component);
+                onRoot(component);
                 continue;
             }
 
-            if (component.type == ComponentType::Node && referenced.find(component.fileOffset) == referenced.end())
-                roots.push_back(component);
+            if (component.type != ComponentType::Node) continue;
+
+            const auto it = fromHidden.find(component.id);
+            if (component.refCount == (it == fromHidden.end() ? 0 : it->second)) onRoot(component);
         }
+    }
 
-        return roots;
+    // Счётчик учитывает и спецификации удалённых компонентов и деталей; узел, на
+    // который ссылаются только они, тоже корень. Деталь получает связи, только если
+    // её тип сменили при непустой спецификации (каталоги прежних версий) — теперь
+    // это запрещено. Таких владельцев обычно мало, их цепочки обходятся, остальные
+    // узлы проверяются по счётчику.
+    // Проход строится один раз и дальше правится событиями (TrackReferencesFromHidden).
+    const std::unordered_map<RecordId, std::uint32_t>& CatalogService::ReferencesFromHidden()
+    {
+        if (m_refsFromHidden.has_value()) return *m_refsFromHidden;
+
+        ComponentQuery deletedOnly;
+        deletedOnly.deleted = true;
+        ComponentQuery activeDetails;
+        activeDetails.deleted = false;
+        activeDetails.type = ComponentType::Detail;
+
+        std::unordered_map<RecordId, std::uint32_t> fromHidden;
+        for (const auto& query : { deletedOnly, activeDetails })
+            for (const auto& owner : m_products.Select(query))
+                for (const auto& spec : m_specs.Chain(owner.firstSpecId))
+                    if (!spec.deleted) fromHidden[spec.componentId]++;
+        return m_refsFromHidden.emplace(std::move(fromHidden));
+    }
+
+    void CatalogService::AdjustReferencesFromHidden(RecordId componentId, int delta)
+    {
+        auto& fromHidden = *m_refsFromHidden;
+        if (delta > 0)
+        {
+            fromHidden[componentId]++;
+            return;
+        }
+
+        const auto it = fromHidden.find(componentId);
+        if (it == fromHidden.end()) return;
+        if (--it->second == 0) fromHidden.erase(it);
+    }
+
+    void CatalogService::TrackReferencesFromHidden(const CatalogEvent& event)
+    {
+        if (!m_refsFromHidden.has_value() || m_applyingExternal) return;
+
+        switch (event.kind)
+        {
+        case CatalogEvent::Kind::ComponentDeleted:
+        case CatalogEvent::Kind::ComponentRestored:
+        {
+            // связи компонента переходят в счёт удалённых или обратно; у детали они там уже есть
+            const auto owner = m_products.ReadRecordAt(event.componentId);
+            if (owner.type == ComponentType::Detail) break;
+
+            const int delta = event.kind == CatalogEvent::Kind::ComponentDeleted ? +1 : -1;
+            for (const auto& spec : m_specs.Chain(owner.firstSpecId))
+                if (!spec.deleted) AdjustReferencesFromHidden(spec.componentId, delta);
+            break;
+        }
+        case CatalogEvent::Kind::LinkAdded:
+        case CatalogEvent::Kind::LinkRemoved:
+        case CatalogEvent::Kind::LinkUpdated:
+        {
+            // свои правки связей идут у действующих владельцев не-деталей; проверка — на всякий случай
+            const auto owner = m_products.ReadRecordAt(event.ownerId);
+            if (!owner.deleted && owner.type != ComponentType::Detail) break;
+            if (event.kind == CatalogEvent::Kind::LinkUpdated) AdjustReferencesFromHidden(event.previousComponentId, -1);
+            AdjustReferencesFromHidden(event.componentId, event.kind == CatalogEvent::Kind::LinkRemoved ? -1 : +1);
+            break;
+        }
+        case CatalogEvent::Kind::Reloaded:
+            m_refsFromHidden.reset();
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool CatalogService::IsSpecificationRoot(RecordId id)
+    {
+        const auto component = ReadComponent(id);
+        if (component.deleted || component.type == ComponentType::Detail) return false;
+        if (component.type == ComponentType::Product || component.refCount == 0) return true;
+
+        const auto& fromHidden = ReferencesFromHidden();
+        const auto it = fromHidden.find(id);
+        return it != fromHidden.end() && it->second == component.refCount;
     }
 
     std::vector<SpecItemView> CatalogService::ListSpecItems(const std::string& ownerName)
     {
+        PS_PROFILE_SPAN("CatalogService::ListSpecItems");
         EnsureOpen();
 
         auto ownerOpt = m_products.FindActiveByName(ownerName);
         if (!ownerOpt.has_value()) throw ValidationException("Компонент-родитель не найден.");
 
-        auto owner = *ownerOpt;
+        return ListSpecItems(ownerOpt->id);
+    }
+
+    std::vector<SpecItemView> CatalogService::ListSpecItems(RecordId ownerId)
+    {
+        PS_PROFILE_SPAN("CatalogService::ListSpecItems");
+        EnsureOpen();
+
+        if (ownerId == NullId || ownerId > m_products.Header().recordCount)
+            throw ValidationException("Компонент-родитель не найден.");
+
+        ComponentRecord owner;
+        m_products.ReadRecordInto(ownerId, owner);
+        if (owner.deleted) throw ValidationException("Компонент-родитель не найден.");
         if (owner.type == ComponentType::Detail) throw ValidationException("У детали нет спецификации.");
 
         std::vector<SpecItemView> out;
-        for (const auto& s : ReadSpecChain(owner.firstSpecPtr))
+        ComponentRecord c;
+        for (const auto& s : m_specs.Chain(owner.firstSpecId))
         {
-            auto c = m_products.ReadRecordAt(s.componentPtr);
+            if (s.deleted) continue;
+
+            m_products.ReadRecordInto(s.componentId, c);
             SpecItemView v;
+            v.specId = s.id;
+            v.partId = c.id;
             v.partName = c.name;
             v.qty = s.qty;
             v.type = c.type;
@@ -455,10 +878,10 @@ namespace ps
 
         if (node.type == ComponentType::Detail) return;
 
-        auto children = ReadSpecChain(node.firstSpecPtr);
+        auto children = ReadChildIds(node.firstSpecId);
         for (std::size_t i = 0; i < children.size(); i++)
         {
-            auto childComp = m_products.ReadRecordAt(children[i].componentPtr);
+            auto childComp = m_products.ReadRecordAt(children[i]);
             auto nextPrefix = prefix + (isLast ? "    " : "|   ");
             PrintTreeRec(out, childComp, nextPrefix, i + 1 == children.size(), depth + 1);
         }
@@ -466,6 +889,7 @@ namespace ps
 
     std::string CatalogService::PrintSpecTree(const std::string& name)
     {
+        PS_PROFILE_SPAN("CatalogService::PrintSpecTree");
         EnsureOpen();
 
         auto compOpt = m_products.FindActiveByName(name);
@@ -475,10 +899,10 @@ namespace ps
         if (comp.type == ComponentType::Detail) throw ValidationException("Для детали Print(имя) недопустима.");
 
         std::string out = comp.name + " (" + ToString(comp.type) + ")\n";
-        auto children = ReadSpecChain(comp.firstSpecPtr);
+        auto children = ReadChildIds(comp.firstSpecId);
         for (std::size_t i = 0; i < children.size(); i++)
         {
-            auto childComp = m_products.ReadRecordAt(children[i].componentPtr);
+            auto childComp = m_products.ReadRecordAt(children[i]);
             PrintTreeRec(out, childComp, "", i + 1 == children.size(), 0);
         }
         return out;
@@ -502,83 +926,120 @@ namespace ps
             << "  Truncate\n"
             << "  Print(имяКомпонента)\n"
             << "  Print(*)\n"
+            << "  Print(префикс*)\n"
+            << "  Find(текст)\n"
+            << "  Select(type=тип, deleted=0|1, name~\"префикс*\")   // любые из условий\n"
             << "  Help [имяФайла]\n"
+            << "  Stats [reset]                              // счётчики ввода-вывода и время команд\n"
+            << "  Profile имяФайла | Profile off             // профиль Chrome trace events\n"
             << "  Exit\n";
         return oss.str();
     }
 
+    void CatalogService::SetCacheCapacity(std::size_t pages) { m_cache.SetCapacity(pages); }
+    const PageCache::Stats& CatalogService::CacheStats() const { return m_cache.GetStats(); }
+    void CatalogService::ResetCacheStats() { m_cache.ResetStats(); }
+
     void CatalogService::Truncate()
     {
+        PS_PROFILE_SPAN("CatalogService::Truncate");
         EnsureOpen();
         TruncateRebuildFiles();
         m_products.RebuildAlphabeticalLinks();
+        Notify(CatalogEvent::Kind::Reloaded, NullId);
     }
 
     void CatalogService::TruncateRebuildFiles()
     {
+        PS_PROFILE_SPAN("CatalogService::TruncateRebuildFiles");
         const auto prdOld = m_products.PrdPath();
         const auto prsOld = m_products.PrsPath();
         const auto prdTmp = prdOld + ".tmp";
         const auto prsTmp = prsOld + ".tmp";
+        const auto sidecarsOld = ProductFile::SidecarPathsFor(prdOld);
+        const auto sidecarsTmp = ProductFile::SidecarPathsFor(prdTmp);
 
-        auto allComponents = m_products.ReadAllRecords();
-        std::vector<ComponentRecord> activeComps;
-        for (auto& c : allComponents)
+        std::unordered_map<RecordId, RecordId> remap;
+
+        ProductFile newPrd;
+        // в заголовке новой .prd сразу итоговое имя .prs, а не временное
+        newPrd.Create(prdTmp, m_products.MaxNameLen(), prsOld, m_backend);
+        SpecFile newPrs;
+        newPrs.Create(prsTmp, m_backend);
+
+        try
+        {
+            CopyActiveRecords(newPrd, newPrs, remap);
+        }
+        catch (...)
         {
-            if (!c.deleted) activeComps.push_back(c);
+            // прежние файлы ещё не тронуты: временные просто удаляются
+            newPrd.Close();
+            newPrs.Close();
+            RemoveStorageFile(m_backend, prdTmp);
+            RemoveStorageFile(m_backend, prsTmp);
+            for (const auto& path : sidecarsTmp) RemoveStorageFile(m_backend, path);
+            throw;
         }
 
-        std::unordered_map<std::uint32_t, std::uint32_t> remap;
+        m_products.Close();
+        m_specs.Close();
 
-        ProductFile newPrd;
-        newPrd.Create(prdTmp, m_products.MaxNameLen(), prsTmp);
-        SpecFile newPrs;
-        newPrs.Create(prsTmp);
+        newPrd.Close();
+        newPrs.Close();
+
+        RemoveStorageFile(m_backend, prdOld);
+        RemoveStorageFile(m_backend, prsOld);
+        for (const auto& path : sidecarsOld) RemoveStorageFile(m_backend, path);
+        RenameStorageFile(m_backend, prdTmp, prdOld);
+        RenameStorageFile(m_backend, prsTmp, prsOld);
+        for (std::size_t i = 0; i < sidecarsTmp.size(); i++) RenameStorageFile(m_backend, sidecarsTmp[i], sidecarsOld[i]);
+
+        m_products.Open(prdOld, m_backend);
+        m_specs.Open(prsOld, m_backend);
+    }
 
-        for (auto& c : activeComps)
+    void CatalogService::CopyActiveRecords(ProductFile& newPrd, SpecFile& newPrs, std::unordered_map<RecordId, RecordId>& remap)
+    {
+        PS_PROFILE_SPAN("CatalogService::CopyActiveRecords");
+        // два прохода по .prd: компоненты, затем их спецификации
+        const auto total = 2 * m_products.Header().recordCount;
+        std::uint64_t done = 0;
+
+        for (const auto& c : m_products.Records())
         {
+            Step(++done, total);
+            if (c.deleted) continue;
+
             auto appended = newPrd.AddComponent(c.name, c.type);
-            remap[c.fileOffset] = appended.fileOffset;
+            remap[c.id] = appended.id;
         }
 
-        for (auto& c : activeComps)
+        for (const auto& c : m_products.Records())
         {
-            if (c.type == ComponentType::Detail) continue;
+            Step(++done, total);
+            if (c.deleted || c.type == ComponentType::Detail) continue;
 
-            std::uint32_t newFirst = NullPtr;
-            std::uint32_t newPrev = NullPtr;
-            std::uint32_t cur = c.firstSpecPtr;
+            RecordId newFirst = NullId;
+            RecordId newPrev = NullId;
 
-            while (cur != NullPtr)
+            for (const auto& sr : m_specs.Chain(c.firstSpecId))
             {
-                auto sr = m_specs.ReadRecordAt(cur);
-                cur = sr.nextPtr;
-
                 if (sr.deleted) continue;
 
-                auto it = remap.find(sr.componentPtr);
+                auto it = remap.find(sr.componentId);
                 if (it == remap.end()) continue;
 
-                auto newSpecOff = newPrs.AddSpecItem(it->second, sr.qty);
-                if (newFirst == NullPtr) newFirst = newSpecOff;
-                else newPrs.UpdateNext(newPrev, newSpecOff);
-                newPrev = newSpecOff;
+                auto newSpecId = newPrs.AddSpecItem(it->second, sr.qty);
+                newPrd.AdjustReferences(it->second, +1);
+                if (newFirst == NullId) newFirst = newSpecId;
+                else newPrs.UpdateNext(newPrev, newSpecId);
+                newPrev = newSpecId;
             }
 
-            auto newOwnerOff = remap[c.fileOffset];
-            auto newOwner = newPrd.ReadRecordAt(newOwnerOff);
-            newPrd.UpdatePointers(newOwner.fileOffset, newFirst, newOwner.nextPtr);
+            auto newOwnerId = remap[c.id];
+            auto newOwner = newPrd.ReadRecordAt(newOwnerId);
+            newPrd.UpdatePointers(newOwner.id, newFirst, newOwner.nextId);
         }
-
-        m_products.Close();
-        m_specs.Close();
-
-        std::remove(prdOld.c_str());
-        std::remove(prsOld.c_str());
-        std::rename(prdTmp.c_str(), prdOld.c_str());
-        std::rename(prsTmp.c_str(), prsOld.c_str());
-
-        m_products.Open(prdOld);
-        m_specs.Open(prsOld);
     }
 }
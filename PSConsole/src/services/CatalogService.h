@@ -1,15 +1,22 @@
 #pragma once
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <optional>
+#include "../core/PageCache.h"
+#include "../core/Progress.h"
 #include "../domain/Models.h"
 #include "../infra/ProductFile.h"
+#include "CatalogEvents.h"
 #include "../infra/SpecFile.h"
 
 namespace ps
 {
     struct SpecItemView
     {
+        RecordId specId = NullId;
+        RecordId partId = NullId;
         std::string partName;
         std::uint16_t qty = 1;
         ComponentType type = ComponentType::Detail;
@@ -18,13 +25,18 @@ namespace ps
     class CatalogService final
     {
     public:
+        CatalogService();
+
         bool HasOpenFiles() const;
 
-        void Create(const std::string& baseName, std::uint16_t maxNameLen, const std::optional<std::string>& prsNameOpt);
-        void Open(const std::string& baseName);
+        // backend: где живут файлы каталога (fstream, pread/pwrite или только память)
+        void Create(const std::string& baseName, std::uint16_t maxNameLen, const std::optional<std::string>& prsNameOpt,
+                    StorageBackend backend = DefaultStorageBackend);
+        void Open(const std::string& baseName, StorageBackend backend = DefaultStorageBackend);
         void Close();
 
-        void InputComponent(const std::string& name, ComponentType type);
+        // возвращает номер записи нового компонента
+        RecordId InputComponent(const std::string& name, ComponentType type);
         void InputSpecItem(const std::string& ownerName, const std::string& partName, std::uint16_t qty = 1);
         void UpdateSpecItem(const std::string& ownerName, const std::string& oldPartName, const std::string& newPartName, std::uint16_t qty = 1);
 
@@ -40,25 +52,93 @@ namespace ps
         void Truncate();
 
         std::vector<ComponentRecord> ListComponents();
+        // номера записей активных компонентов в порядке ListComponents; сами записи —
+        // ReadComponent по мере надобности
+        std::vector<RecordId> ListComponentIds();
+        ComponentRecord ReadComponent(RecordId id);
+        // по началу имени без учёта регистра, по алфавиту; limit — для подсказок при вводе имени
+        std::vector<ComponentRecord> ListComponentsByPrefix(const std::string& prefix, std::size_t limit = SIZE_MAX);
+        // Поиск по части имени без учёта регистра: первые 100 по алфавиту; если
+        // таких нет — имена, отличающиеся от text опечаткой (ближайшие первыми).
+        std::vector<ComponentRecord> FindComponents(const std::string& text);
+        // отбор по типу, признаку удаления и имени; включая удалённые, если это не исключено условием
+        std::vector<ComponentRecord> SelectComponents(const ComponentQuery& query);
         std::vector<ComponentRecord> ListSpecificationRoots();
+        // входит ли компонент в ListSpecificationRoots (без построения всего списка)
+        bool IsSpecificationRoot(RecordId id);
+        // те же корни по одному, по мере нахождения
+        void ListSpecificationRoots(const std::function<void(const ComponentRecord&)>& onRoot);
         std::vector<SpecItemView> ListSpecItems(const std::string& ownerName);
+        // то же по номеру записи владельца (из ComponentRecord::id или SpecItemView::partId),
+        // без поиска по имени
+        std::vector<SpecItemView> ListSpecItems(RecordId ownerId);
         std::string PrintSpecTree(const std::string& name);
 
         std::string HelpText() const;
 
-    private:
-        static constexpr std::uint32_t NullPtr = 1;
+        // Наблюдатель долгих операций (Open, Truncate, ListComponentIds, ListSpecificationRoots):
+        // получает ход выполнения и может их прервать (OperationCancelled).
+        // nullptr — без наблюдателя.
+        void SetProgress(Progress* progress);
+
+        // Подписка на изменения каталога (см. CatalogEvent); возвращает номер
+        // подписки для Unsubscribe. Подписчик вызывается синхронно из операции
+        // и не должен сам менять каталог.
+        std::size_t Subscribe(CatalogListener listener);
+        void Unsubscribe(std::size_t subscription);
 
+        // Следить за изменениями, которые вносит в открытый каталог другой процесс.
+        // Каталог держит снимок записей .prd и .prs (памяти — сколько они занимают
+        // на диске): он берётся при Open/Create и обновляется своими изменениями.
+        void WatchExternalChanges(bool enabled);
+        // Проверить, не изменил ли каталог другой процесс. Пока изменений нет, это
+        // одно чтение заголовка .prd; иначе перечитываются только изменившиеся записи,
+        // и подписчики получают по ним обычные события. Файлы, перестроенные целиком
+        // (Truncate), открываются заново с событием Reloaded. Возвращает true, если
+        // изменения были; без WatchExternalChanges(true) всегда false.
+        bool PollExternalChanges();
+
+        // кэш страниц, общий для .prd и .prs
+        void SetCacheCapacity(std::size_t pages);
+        const PageCache::Stats& CacheStats() const;
+        void ResetCacheStats();
+
+    private:
+        StorageBackend m_backend = DefaultStorageBackend;
+        PageCache m_cache; // объявлен до файлов: должен пережить их
+        Progress* m_progress = nullptr;
+        std::vector<std::pair<std::size_t, CatalogListener>> m_listeners;
+        std::size_t m_nextSubscription = 1;
+        bool m_watchExternal = false;
+        bool m_applyingExternal = false; // PollExternalChanges рассылает события уже применённых изменений
         ProductFile m_products;
         SpecFile m_specs;
+        // ReferencesFromHidden: строится при первом обращении, дальше правится по событиям
+        std::optional<std::unordered_map<RecordId, std::uint32_t>> m_refsFromHidden;
 
         static std::string EnsureExt(const std::string& base, const std::string& ext);
         void EnsureOpen() const;
+        // отметить шаг долгой операции; бросает OperationCancelled по запросу наблюдателя
+        void Step(std::uint64_t done, std::uint64_t total);
+        void Notify(const CatalogEvent& event);
+        void Notify(CatalogEvent::Kind kind, RecordId componentId);
+        // обновить снимок по своему изменению, чтобы при сверке оно не выглядело чужим
+        void Remember(const CatalogEvent& event);
+        // владелец каждой записи .prs по снимкам (NullId — запись вне цепочек)
+        std::vector<RecordId> SnapshotSpecOwners() const;
+        // Узлы, на которые ссылаются спецификации скрытых владельцев (удалённых и
+        // деталей: их состав в дереве не показывается), и число таких ссылок
+        const std::unordered_map<RecordId, std::uint32_t>& ReferencesFromHidden();
+        // поправить m_refsFromHidden по своему изменению
+        void TrackReferencesFromHidden(const CatalogEvent& event);
+        void AdjustReferencesFromHidden(RecordId componentId, int delta);
 
-        std::vector<SpecRecord> ReadSpecChain(std::uint32_t firstSpecPtr);
-        bool WouldCreateCycle(std::uint32_t ownerPtr, std::uint32_t partPtr);
+        std::vector<RecordId> ReadChildIds(RecordId firstSpecId);
+        bool WouldCreateCycle(RecordId ownerId, RecordId partId);
         void PrintTreeRec(std::string& out, const ComponentRecord& node, const std::string& prefix, bool isLast, int depth);
 
         void TruncateRebuildFiles();
+        void CopyActiveRecords(ProductFile& newPrd, SpecFile& newPrs, std::unordered_map<RecordId, RecordId>& remap);
+        void RecountReferences();
     };
 }
@@ -0,0 +1,67 @@
+#include "CommandStats.h"
+#include <cstdio>
+#include <sstream>
+
+namespace ps
+{
+    void CommandStats::Record(const std::string& name, std::uint64_t ns, const OperationCounters& operations)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // команд десяток: линейный поиск дешевле словаря
+        auto it = m_entries.begin();
+        while (it != m_entries.end() && it->name != name) ++it;
+        if (it == m_entries.end())
+        {
+            m_entries.push_back({ name, {}, {} });
+            it = m_entries.end() - 1;
+        }
+
+        it->latency.Record(ns);
+        it->operations += operations;
+    }
+
+    void CommandStats::Reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    std::vector<CommandStats::Entry> CommandStats::Entries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries;
+    }
+
+    CommandStats& ProcessCommandStats()
+    {
+        static CommandStats stats;
+        return stats;
+    }
+
+    static std::string Microseconds(std::uint64_t ns)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.1f", static_cast<double>(ns) / 1e3);
+        return buf;
+    }
+
+    std::string FormatCommandStats(const std::vector<CommandStats::Entry>& entries)
+    {
+        using C = OperationCounter;
+        std::ostringstream oss;
+        oss << "Команда\tвызовов\tp50, мкс\tp90, мкс\tp99, мкс\tmax, мкс"
+            << "\tзаписей прочитано\tзаписей записано\tчтений\tзаписей\tсбросов\n";
+        for (const auto& e : entries)
+        {
+            const auto& h = e.latency;
+            const auto& o = e.operations;
+            oss << e.name << "\t" << h.Count();
+            for (const double p : { 50.0, 90.0, 99.0 }) oss << "\t" << Microseconds(h.PercentileNs(p));
+            oss << "\t" << Microseconds(h.MaxNs())
+                << "\t" << o[C::ProductReads] + o[C::SpecReads] << "\t" << o[C::ProductWrites] + o[C::SpecWrites]
+                << "\t" << o[C::Reads] << "\t" << o[C::Writes] << "\t" << o[C::Flushes] << "\n";
+        }
+        return oss.str();
+    }
+}
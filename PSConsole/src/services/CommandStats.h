@@ -0,0 +1,39 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../core/LatencyHistogram.h"
+#include "../core/OperationStats.h"
+
+namespace ps
+{
+    // Сводка по командам: задержка каждого вызова и обращения к файлам за время
+    // его выполнения. Заполняется там, где команды передаются обработчикам
+    // (цикл в main.cpp), читается и сбрасывается командой Stats.
+    class CommandStats final
+    {
+    public:
+        struct Entry
+        {
+            std::string name;
+            LatencyHistogram latency;
+            OperationCounters operations; // сумма по всем вызовам
+        };
+
+        void Record(const std::string& name, std::uint64_t ns, const OperationCounters& operations);
+        void Reset();
+
+        // в порядке первого вызова команды
+        std::vector<Entry> Entries() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<Entry> m_entries;
+    };
+
+    CommandStats& ProcessCommandStats();
+
+    // таблица по командам: вызовы, p50/p90/p99/max в мкс и обращения к файлам
+    // (её выводят Stats и ps_replay)
+    std::string FormatCommandStats(const std::vector<CommandStats::Entry>& entries);
+}
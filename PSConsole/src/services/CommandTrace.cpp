@@ -0,0 +1,55 @@
+#include "CommandTrace.h"
+#include "../core/Errors.h"
+
+namespace ps
+{
+    static const char* TraceHeader = "# ps-trace 1";
+
+    CommandTraceWriter::CommandTraceWriter(const std::string& path)
+        : m_path(path), m_out(path, std::ios::binary | std::ios::trunc), m_start(std::chrono::steady_clock::now())
+    {
+        if (!m_out) throw FileException("Не удалось создать файл записи команд: " + path);
+        m_out << TraceHeader << '\n';
+        m_out.flush();
+    }
+
+    void CommandTraceWriter::Record(const ParsedCommand& cmd)
+    {
+        const auto offset = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count();
+        m_out << offset << '\t' << cmd.raw << '\n';
+        m_out.flush();
+        if (!m_out) throw FileException("Ошибка записи в файл записи команд: " + m_path);
+    }
+
+    std::vector<TraceEntry> ReadCommandTrace(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw FileException("Не удалось открыть файл записи команд: " + path);
+
+        std::string line;
+        if (!std::getline(in, line) || line != TraceHeader)
+            throw FileException("Файл " + path + " не является записью команд.");
+
+        std::vector<TraceEntry> entries;
+        std::size_t lineNo = 1;
+        while (std::getline(in, line))
+        {
+            lineNo++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            const auto tab = line.find('\t');
+            std::size_t digits = 0;
+            while (digits < tab && digits < line.size() && line[digits] >= '0' && line[digits] <= '9') digits++;
+            if (tab == std::string::npos || digits == 0 || digits != tab || digits > 19)
+                throw FileException("Запись команд " + path + ", строка " + std::to_string(lineNo) + ": ожидается время и команда.");
+
+            TraceEntry e;
+            e.offsetUs = std::stoull(line.substr(0, tab));
+            e.command = ParseCommandLine(line.substr(tab + 1));
+            entries.push_back(std::move(e));
+        }
+        if (in.bad()) throw FileException("Ошибка чтения файла записи команд: " + path);
+        return entries;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../domain/Parsing.h"
+
+namespace ps
+{
+    // Запись команд, переданных обработчикам, для воспроизведения нагрузки
+    // (ps_replay). Текстовый файл: первая строка — заголовок "# ps-trace 1",
+    // далее по строке на команду: микросекунды от начала записи, табуляция,
+    // исходная строка команды (ParsedCommand::raw, UTF-8). Команда при
+    // воспроизведении разбирается заново через ParseCommandLine.
+    struct TraceEntry
+    {
+        std::uint64_t offsetUs = 0;
+        ParsedCommand command;
+    };
+
+    class CommandTraceWriter final
+    {
+    public:
+        // файл перезаписывается; ошибка открытия — FileException
+        explicit CommandTraceWriter(const std::string& path);
+
+        // строка сбрасывается на диск сразу: запись переживает аварийное завершение
+        void Record(const ParsedCommand& cmd);
+
+    private:
+        std::string m_path;
+        std::ofstream m_out;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // ошибка чтения или формата — FileException
+    std::vector<TraceEntry> ReadCommandTrace(const std::string& path);
+}
@@ -1,6 +1,8 @@
 #include "Commands.h"
 #include "../core/Errors.h"
+#include "../core/Profiling.h"
 #include "../domain/Models.h"
+#include "CommandStats.h"
 #include <sstream>
 #include <fstream>
 
@@ -177,9 +179,10 @@ namespace ps
             {
                 if (cmd.args.size() < 1) { r.error = "Print: ожидается имя компонента или *."; return r; }
 
-                if (cmd.args[0] == "*")
+                const auto& arg = cmd.args[0];
+                if (arg == "*" || (arg.size() > 1 && arg.back() == '*'))
                 {
-                    auto list = svc.ListComponents();
+                    auto list = arg == "*" ? svc.ListComponents() : svc.ListComponentsByPrefix(arg.substr(0, arg.size() - 1));
                     std::ostringstream oss;
                     oss << "Наименование\tТип\n";
                     for (const auto& c : list) oss << c.name << "\t" << ToString(c.type) << "\n";
@@ -187,7 +190,57 @@ namespace ps
                     return r;
                 }
 
-                r.output = svc.PrintSpecTree(cmd.args[0]);
+                r.output = svc.PrintSpecTree(arg);
+            }
+            catch (const PsException& ex) { r.error = ex.what(); }
+            return r;
+        }
+    };
+
+    class FindCommand final : public ICommand
+    {
+    public:
+        std::string Name() const override { return "Find"; }
+        CommandResult Execute(const ParsedCommand& cmd, CatalogService& svc) override
+        {
+            CommandResult r;
+            try
+            {
+                if (cmd.args.size() < 1) { r.error = "Find: ожидается часть имени компонента."; return r; }
+
+                auto list = svc.FindComponents(cmd.args[0]);
+                if (list.empty()) { r.output = "Ничего не найдено.\n"; return r; }
+
+                std::ostringstream oss;
+                oss << "Наименование\tТип\n";
+                for (const auto& c : list) oss << c.name << "\t" << ToString(c.type) << "\n";
+                r.output = oss.str();
+            }
+            catch (const PsException& ex) { r.error = ex.what(); }
+            return r;
+        }
+    };
+
+    class SelectCommand final : public ICommand
+    {
+    public:
+        std::string Name() const override { return "Select"; }
+        CommandResult Execute(const ParsedCommand& cmd, CatalogService& svc) override
+        {
+            CommandResult r;
+            try
+            {
+                auto list = svc.SelectComponents(ParseComponentQuery(cmd.args));
+
+                std::ostringstream oss;
+                oss << "Наименование\tТип\n";
+                for (const auto& c : list)
+                {
+                    oss << c.name << "\t" << ToString(c.type);
+                    if (c.deleted) oss << "\t(удалён)";
+                    oss << "\n";
+                }
+                r.output = oss.str();
             }
             catch (const PsException& ex) { r.error = ex.what(); }
             return r;
@@ -215,6 +268,75 @@ namespace ps
         }
     };
 
+    // Stats — счётчики OperationStats.h, кэш страниц и сводка по командам
+    // (CommandStats); Stats reset — обнулить всё это.
+    class StatsCommand final : public ICommand
+    {
+    public:
+        std::string Name() const override { return "Stats"; }
+        CommandResult Execute(const ParsedCommand& cmd, CatalogService& svc) override
+        {
+            CommandResult r;
+            if (!cmd.args.empty())
+            {
+                if (cmd.args[0] != "reset") { r.error = "Stats: ожидается reset или ничего."; return r; }
+                ResetOperationCounters();
+                svc.ResetCacheStats();
+                ProcessCommandStats().Reset();
+                r.output = "OK\n";
+                return r;
+            }
+
+            using C = OperationCounter;
+            const auto ops = ReadOperationCounters();
+            const auto& cache = svc.CacheStats();
+
+            std::ostringstream oss;
+            oss << "Хранилище: позиционирований " << ops[C::Seeks]
+                << ", чтений " << ops[C::Reads] << " (" << ops[C::BytesRead] << " байт)"
+                << ", записей " << ops[C::Writes] << " (" << ops[C::BytesWritten] << " байт)"
+                << ", сбросов " << ops[C::Flushes] << "\n";
+            oss << "Записи .prd: прочитано " << ops[C::ProductReads] << ", записано " << ops[C::ProductWrites] << "\n";
+            oss << "Записи .prs: прочитано " << ops[C::SpecReads] << ", записано " << ops[C::SpecWrites] << "\n";
+            oss << "Кэш страниц: попаданий " << cache.hits << ", промахов " << cache.misses
+                << ", вытеснений " << cache.evictions << ", записано страниц " << cache.writeBacks << "\n";
+
+            const auto entries = ProcessCommandStats().Entries();
+            if (!entries.empty()) oss << "\n" << FormatCommandStats(entries);
+            r.output = oss.str();
+            return r;
+        }
+    };
+
+    // Profile имяФайла — начать запись профиля (Chrome trace events),
+    // Profile off — записать файл и закончить.
+    class ProfileCommand final : public ICommand
+    {
+    public:
+        std::string Name() const override { return "Profile"; }
+        CommandResult Execute(const ParsedCommand& cmd, CatalogService&) override
+        {
+            CommandResult r;
+            try
+            {
+                if (cmd.args.empty()) { r.error = "Profile: ожидается имя файла или off."; return r; }
+
+                if (cmd.args[0] == "off")
+                {
+                    if (!ProfilingActive()) { r.error = "Profile: запись профиля не идёт."; return r; }
+                    StopProfiling();
+                }
+                else
+                {
+                    StartProfiling(cmd.args[0]);
+                }
+                r.output = "OK\n";
+            }
+            catch (const PsException& ex) { r.error = ex.what(); }
+            return r;
+        }
+    };
+
     class ExitCommand final : public ICommand
     {
     public:
@@ -238,7 +360,11 @@ namespace ps
         cmds.push_back(std::make_unique<RestoreCommand>());
         cmds.push_back(std::make_unique<TruncateCommand>());
         cmds.push_back(std::make_unique<PrintCommand>());
+        cmds.push_back(std::make_unique<FindCommand>());
+        cmds.push_back(std::make_unique<SelectCommand>());
         cmds.push_back(std::make_unique<HelpCommand>());
+        cmds.push_back(std::make_unique<StatsCommand>());
+        cmds.push_back(std::make_unique<ProfileCommand>());
         cmds.push_back(std::make_unique<ExitCommand>());
         return cmds;
     }
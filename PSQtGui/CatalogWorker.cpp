@@ -0,0 +1,105 @@
+#include "CatalogWorker.h"
+
+#include "core/Errors.h"
+#include "services/CatalogService.h"
+
+void CatalogTask::cancel() { m_cancel = true; }
+
+bool CatalogTask::Cancelled() const { return m_cancel; }
+
+void CatalogTask::publish(const QVariant& chunk) { emit partial(chunk); }
+
+void CatalogTask::Report(std::uint64_t done, std::uint64_t total)
+{
+    // окну хватает тысячи отметок за операцию
+    const int permille = total == 0 ? 0 : static_cast<int>(done * 1000 / total);
+    if (permille == m_lastPermille) return;
+
+    m_lastPermille = permille;
+    emit progress(static_cast<qint64>(done), static_cast<qint64>(total));
+}
+
+CatalogWorker::CatalogWorker(ps::CatalogService* service, QObject* parent)
+    : QObject(parent), m_service(service)
+{
+    m_subscription = m_service->Subscribe([this](const ps::CatalogEvent& event) { emit catalogChanged(event); });
+
+    m_context = new QObject();
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.start();
+}
+
+CatalogWorker::~CatalogWorker()
+{
+    cancelAndWait();
+    m_thread.quit();
+    m_thread.wait();
+    m_service->Unsubscribe(m_subscription);
+}
+
+ps::CatalogService* CatalogWorker::service() const { return m_service; }
+
+bool CatalogWorker::isBusy() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_busy;
+}
+
+CatalogTask* CatalogWorker::start(Function fn)
+{
+    auto* task = new CatalogTask();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_busy)
+        {
+            delete task;
+            return nullptr;
+        }
+        m_busy = true;
+        m_current = task;
+    }
+
+    emit busyChanged(true);
+    QMetaObject::invokeMethod(m_context, [this, task, fn = std::move(fn)] { run(task, fn); }, Qt::QueuedConnection);
+    return task;
+}
+
+void CatalogWorker::cancelAndWait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_current != nullptr) m_current->cancel();
+    m_idle.wait(lock, [this] { return !m_busy; });
+}
+
+void CatalogWorker::run(CatalogTask* task, const Function& fn)
+{
+    // сигналы задачи отсюда уходят в поток окна очередью
+    m_service->SetProgress(task);
+    try
+    {
+        const auto result = fn(*m_service, *task);
+        m_service->SetProgress(nullptr);
+        emit task->finished(result);
+    }
+    catch (const ps::OperationCancelled&)
+    {
+        m_service->SetProgress(nullptr);
+        emit task->cancelled();
+    }
+    catch (const std::exception& ex)
+    {
+        m_service->SetProgress(nullptr);
+        emit task->failed(QString::fromUtf8(ex.what()));
+    }
+    task->deleteLater();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = false;
+        m_current = nullptr;
+    }
+    // до notify: после него cancelAndWait возвращается, и окно может удалить объект
+    emit busyChanged(false);
+    m_idle.notify_all();
+}
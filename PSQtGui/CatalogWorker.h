@@ -0,0 +1,89 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QVariant>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "core/Progress.h"
+#include "services/CatalogEvents.h"
+
+namespace ps { class CatalogService; }
+
+Q_DECLARE_METATYPE(ps::CatalogEvent)
+
+// Одна операция, запущенная через CatalogWorker. Сигналы приходят в поток окна;
+// после finished/failed/cancelled объект удаляется сам (deleteLater), поэтому
+// держать его стоит через QPointer.
+class CatalogTask final : public QObject, public ps::Progress
+{
+    Q_OBJECT
+public:
+    // из потока окна: операция прервётся на ближайшей проверке в каталоге
+    void cancel();
+
+    // из функции операции: передать окну промежуточный результат (сигнал partial)
+    void publish(const QVariant& chunk);
+
+    void Report(std::uint64_t done, std::uint64_t total) override;
+    bool Cancelled() const override;
+
+signals:
+    void progress(qint64 done, qint64 total);
+    void partial(const QVariant& chunk);
+    void finished(const QVariant& result);
+    void failed(const QString& message);
+    void cancelled();
+
+private:
+    std::atomic<bool> m_cancel{ false };
+    int m_lastPermille = -1;
+};
+
+// Выполняет операции каталога в отдельном потоке, чтобы окно не замирало
+// на Open, Truncate, построении дерева и т.п.
+//
+// CatalogService не потокобезопасен, поэтому операции идут по одной, а пока
+// операция выполняется (isBusy), окно не обращается к каталогу напрямую.
+// Короткие вызовы (одна запись, одна спецификация) окно делает само через service().
+// Изменения каталога приходят сигналом catalogChanged в поток окна, кто бы их ни сделал.
+class CatalogWorker final : public QObject
+{
+    Q_OBJECT
+public:
+    // выполняется в потоке операций; результат — в CatalogTask::finished
+    using Function = std::function<QVariant(ps::CatalogService&, CatalogTask&)>;
+
+    explicit CatalogWorker(ps::CatalogService* service, QObject* parent = nullptr);
+    ~CatalogWorker() override;
+
+    ps::CatalogService* service() const;
+    bool isBusy() const;
+
+    // nullptr — уже выполняется другая операция
+    CatalogTask* start(Function fn);
+
+    // отменить текущую операцию и дождаться её завершения (сигналы о ней ещё придут)
+    void cancelAndWait();
+
+signals:
+    void busyChanged(bool busy);
+    // из операции в потоке окна — сразу, из фоновой — очередью
+    void catalogChanged(const ps::CatalogEvent& event);
+
+private:
+    ps::CatalogService* m_service = nullptr;
+    std::size_t m_subscription = 0;
+    QThread m_thread;
+    QObject* m_context = nullptr; // живёт в m_thread: через него туда передаются операции
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    bool m_busy = false;
+    CatalogTask* m_current = nullptr;
+
+    void run(CatalogTask* task, const Function& fn);
+};
@@ -0,0 +1,178 @@
+#include "ComponentTableModel.h"
+
+#include <algorithm>
+
+#include "CatalogWorker.h"
+#include "core/Errors.h"
+#include "domain/Collation.h"
+#include "services/CatalogService.h"
+
+static constexpr int CachedRecords = 4096; // несколько экранов в обе стороны
+
+ComponentTableModel::ComponentTableModel(CatalogWorker* worker, QObject* parent)
+    : QAbstractTableModel(parent), m_worker(worker), m_service(worker->service()), m_records(CachedRecords)
+{
+    // строки, оставшиеся пустыми на время операции, дочитываются после неё
+    connect(m_worker, &CatalogWorker::busyChanged, this, [this](bool busy)
+    {
+        if (!busy && rowCount() > 0) emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
+    });
+}
+
+void ComponentTableModel::reset(std::vector<ps::RecordId> ids)
+{
+    beginResetModel();
+    m_ids = std::move(ids);
+    m_records.clear();
+    endResetModel();
+}
+
+const ps::ComponentRecord* ComponentTableModel::cached(ps::RecordId id) const
+{
+    if (auto* rec = m_records.object(id)) return rec;
+    // каталог читает поток операций (см. CatalogWorker)
+    if (m_worker->isBusy()) return nullptr;
+
+    try
+    {
+        auto* rec = new ps::ComponentRecord(m_service->ReadComponent(id));
+        m_records.insert(id, rec);
+        return rec;
+    }
+    catch (const ps::PsException&)
+    {
+        // строка остаётся пустой; сообщение даст следующая операция с каталогом
+        return nullptr;
+    }
+}
+
+ps::ComponentRecord ComponentTableModel::recordAt(int row) const
+{
+    if (row < 0 || row >= rowCount()) return {};
+
+    const auto* rec = cached(m_ids[static_cast<std::size_t>(row)]);
+    return rec ? *rec : ps::ComponentRecord{};
+}
+
+int ComponentTableModel::rowOf(ps::RecordId id) const
+{
+    // номера записей не упорядочены, но 8 байт на строку просматриваются быстро
+    const auto it = std::find(m_ids.begin(), m_ids.end(), id);
+    return it == m_ids.end() ? -1 : static_cast<int>(it - m_ids.begin());
+}
+
+void ComponentTableModel::applyEvent(const ps::CatalogEvent& event)
+{
+    switch (event.kind)
+    {
+    case ps::CatalogEvent::Kind::ComponentAdded:
+    case ps::CatalogEvent::Kind::ComponentRestored:
+        if (rowOf(event.componentId) < 0) componentAdded(event.componentId);
+        break;
+    case ps::CatalogEvent::Kind::ComponentChanged:
+        componentChanged(rowOf(event.componentId));
+        break;
+    case ps::CatalogEvent::Kind::ComponentDeleted:
+        componentRemoved(rowOf(event.componentId));
+        break;
+    default:
+        // связи в списке не видны
+        break;
+    }
+}
+
+int ComponentTableModel::insertPosition(const std::string& key, int skipRow) const
+{
+    // двоичный поиск по строкам без skipRow; записи читаются только в точках деления
+    auto realRow = [&](int v) { return skipRow >= 0 && v >= skipRow ? v + 1 : v; };
+
+    int lo = 0;
+    int hi = rowCount() - (skipRow >= 0 ? 1 : 0);
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (ps::CollationKey(recordAt(realRow(mid)).name) < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void ComponentTableModel::componentAdded(ps::RecordId id)
+{
+    ps::ComponentRecord rec;
+    try
+    {
+        rec = m_service->ReadComponent(id);
+    }
+    catch (const ps::PsException& ex)
+    {
+        emit loadFailed(QString::fromUtf8(ex.what()));
+        return;
+    }
+
+    const int row = insertPosition(ps::CollationKey(rec.name), -1);
+    beginInsertRows({}, row, row);
+    m_ids.insert(m_ids.begin() + row, id);
+    m_records.insert(id, new ps::ComponentRecord(std::move(rec)));
+    endInsertRows();
+}
+
+void ComponentTableModel::componentChanged(int row)
+{
+    if (row < 0 || row >= rowCount()) return;
+
+    const auto id = m_ids[static_cast<std::size_t>(row)];
+    m_records.remove(id);
+
+    const auto* rec = cached(id);
+    if (rec == nullptr) return;
+
+    const int target = insertPosition(ps::CollationKey(rec->name), row);
+    if (target != row)
+    {
+        // beginMoveRows ждёт позицию вставки до удаления строки
+        beginMoveRows({}, row, row, {}, target > row ? target + 1 : target);
+        m_ids.erase(m_ids.begin() + row);
+        m_ids.insert(m_ids.begin() + target, id);
+        endMoveRows();
+    }
+
+    emit dataChanged(index(target, 0), index(target, columnCount() - 1));
+}
+
+void ComponentTableModel::componentRemoved(int row)
+{
+    if (row < 0 || row >= rowCount()) return;
+
+    beginRemoveRows({}, row, row);
+    m_records.remove(m_ids[static_cast<std::size_t>(row)]);
+    m_ids.erase(m_ids.begin() + row);
+    endRemoveRows();
+}
+
+int ComponentTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_ids.size());
+}
+
+int ComponentTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 2;
+}
+
+QVariant ComponentTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole) return {};
+
+    const auto* rec = cached(m_ids[static_cast<std::size_t>(index.row())]);
+    if (rec == nullptr) return {};
+
+    if (index.column() == 0) return QString::fromUtf8(rec->name.c_str());
+    return QString::fromUtf8(ps::ToString(rec->type).c_str());
+}
+
+QVariant ComponentTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return {};
+    return section == 0 ? QString::fromUtf8("Наименование") : QString::fromUtf8("Тип");
+}
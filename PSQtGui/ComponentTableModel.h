@@ -0,0 +1,57 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QCache>
+
+#include <vector>
+
+#include "domain/Models.h"
+#include "services/CatalogEvents.h"
+
+namespace ps { class CatalogService; }
+class CatalogWorker;
+
+// Список компонентов (наименование, тип) без копии каталога в памяти: модель
+// хранит только номера записей в алфавитном порядке, а сами записи читает
+// у каталога, когда вид запрашивает строку, и держит недавние в кэше.
+// События каталога (applyEvent) меняют одну строку, а не весь список.
+// Пока worker занят операцией, записи не читаются: строки вне кэша остаются
+// пустыми и перерисовываются, когда он освободится.
+class ComponentTableModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit ComponentTableModel(CatalogWorker* worker, QObject* parent = nullptr);
+
+    // новый список строк (номера записей из CatalogService::ListComponentIds)
+    void reset(std::vector<ps::RecordId> ids);
+
+    // запись строки; пустая запись, если строки нет или её не удалось прочитать
+    ps::ComponentRecord recordAt(int row) const;
+    // строка компонента; -1, если его нет в списке
+    int rowOf(ps::RecordId id) const;
+
+    // Отразить изменение компонента. Reloaded модель не обрабатывает: новый
+    // список номеров даёт reset.
+    void applyEvent(const ps::CatalogEvent& event);
+
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    void loadFailed(const QString& message);
+
+private:
+    CatalogWorker* m_worker = nullptr;
+    ps::CatalogService* m_service = nullptr;
+    std::vector<ps::RecordId> m_ids;
+    mutable QCache<ps::RecordId, ps::ComponentRecord> m_records;
+
+    const ps::ComponentRecord* cached(ps::RecordId id) const;
+    void componentAdded(ps::RecordId id);
+    void componentChanged(int row); // имя могло поменяться: строка переезжает на своё место
+    void componentRemoved(int row);
+    // строка, перед которой встаёт имя с ключом key (skipRow не учитывается)
+    int insertPosition(const std::string& key, int skipRow) const;
+};
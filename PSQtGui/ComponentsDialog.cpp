@@ -1,4 +1,6 @@
 #include "ComponentsDialog.h"
+#include "CatalogWorker.h"
+#include "ComponentTableModel.h"
 
 #include <QAbstractItemView>
 #include <QComboBox>
@@ -6,8 +8,9 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QItemSelectionModel>
 #include <QMessageBox>
-#include <QTableWidget>
+#include <QTableView>
 #include <QToolBar>
 #include <QVBoxLayout>
 
@@ -28,8 +31,15 @@ static ps::ComponentType indexToType(int i)
     return ps::ComponentType::Detail;
 }
 
-ComponentsDialog::ComponentsDialog(ps::CatalogService* service, QWidget* parent)
-    : QDialog(parent), m_service(service)
+static int typeToIndex(ps::ComponentType t)
+{
+    if (t == ps::ComponentType::Product) return 0;
+    if (t == ps::ComponentType::Node) return 1;
+    return 2;
+}
+
+ComponentsDialog::ComponentsDialog(CatalogWorker* worker, QWidget* parent)
+    : QDialog(parent), m_worker(worker), m_service(worker->service())
 {
     setWindowTitle(QString::fromUtf8("Список компонентов"));
     resize(520, 360);
@@ -51,15 +61,26 @@ ComponentsDialog::ComponentsDialog(ps::CatalogService* service, QWidget* parent)
     connect(m_actDelete, &QAction::triggered, this, &ComponentsDialog::onDelete);
     root->addWidget(tb);
 
-    m_table = new QTableWidget(this);
-    m_table->setColumnCount(2);
-    m_table->setHorizontalHeaderLabels({ QString::fromUtf8("Наименование"), QString::fromUtf8("Тип") });
+    // строки читаются из каталога по мере прокрутки
+    m_model = new ComponentTableModel(m_worker, this);
+    connect(m_model, &ComponentTableModel::loadFailed, this, &ComponentsDialog::showError);
+    // правки из этого окна и откуда угодно ещё меняют список по одной строке
+    connect(m_worker, &CatalogWorker::catalogChanged, this, [this](const ps::CatalogEvent& event)
+    {
+        if (event.kind == ps::CatalogEvent::Kind::Reloaded) reloadTable();
+        else m_model->applyEvent(event);
+    });
+
+    m_table = new QTableView(this);
+    m_table->setModel(m_model);
     m_table->horizontalHeader()->setStretchLastSection(true);
     m_table->verticalHeader()->setVisible(false);
+    // высота строк не зависит от содержимого: виду не нужно читать все записи
+    m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_table->setSelectionMode(QAbstractItemView::SingleSelection);
     m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    connect(m_table, &QTableWidget::itemSelectionChanged, this, &ComponentsDialog::onSelectionChanged);
+    connect(m_table->selectionModel(), &QItemSelectionModel::selectionChanged, this, &ComponentsDialog::onSelectionChanged);
     root->addWidget(m_table, 1);
 
     auto* bottom = new QHBoxLayout();
@@ -77,8 +98,14 @@ ComponentsDialog::ComponentsDialog(ps::CatalogService* service, QWidget* parent)
     bottom->addWidget(m_type, 1);
     root->addLayout(bottom);
 
-    reloadTable();
     setMode(Mode::View);
+    reloadTable();
+}
+
+ComponentsDialog::~ComponentsDialog()
+{
+    // загрузка списка не должна пережить диалог
+    if (!m_loadTask.isNull()) m_worker->cancelAndWait();
 }
 
 void ComponentsDialog::showError(const QString& msg)
@@ -97,7 +124,7 @@ void ComponentsDialog::setMode(Mode m)
     m_actSave->setEnabled(editing);
     m_actCancel->setEnabled(editing);
 
-    const bool hasSelection = !m_table->selectedItems().isEmpty();
+    const bool hasSelection = currentRow() >= 0;
     m_actEdit->setEnabled(!editing && hasSelection);
     m_actDelete->setEnabled(!editing && hasSelection);
     m_actAdd->setEnabled(!editing);
@@ -117,31 +144,69 @@ void ComponentsDialog::setMode(Mode m)
 
 void ComponentsDialog::reloadTable()
 {
-    try
+    // список номеров записей собирается в потоке каталога; строки затем читает модель
+    m_loadTask = m_worker->start([](ps::CatalogService& service, CatalogTask&)
     {
-        const auto list = m_service->ListComponents();
+        return QVariant::fromValue(service.ListComponentIds());
+    });
+    if (m_loadTask.isNull())
+    {
+        showError(QString::fromUtf8("Каталог занят другой операцией."));
+        return;
+    }
 
-        m_table->setRowCount(static_cast<int>(list.size()));
-        for (int i = 0; i < static_cast<int>(list.size()); i++)
-        {
-            const auto& item = list[static_cast<std::size_t>(i)];
-            m_table->setItem(i, 0, new QTableWidgetItem(QString::fromUtf8(item.name.c_str())));
-            m_table->setItem(i, 1, new QTableWidgetItem(QString::fromUtf8(ps::ToString(item.type).c_str())));
-        }
+    setLoading(true);
+    connect(m_loadTask, &CatalogTask::finished, this, [this](const QVariant& ids)
+    {
+        m_model->reset(ids.value<std::vector<ps::RecordId>>());
+        setLoading(false);
+        if (m_model->rowCount() > 0) selectRow(0);
+    });
+    connect(m_loadTask, &CatalogTask::failed, this, [this](const QString& message)
+    {
+        setLoading(false);
+        showError(message);
+    });
+    connect(m_loadTask, &CatalogTask::cancelled, this, [this] { setLoading(false); });
+}
 
-        if (m_table->rowCount() > 0) m_table->selectRow(0);
+void ComponentsDialog::setLoading(bool loading)
+{
+    // пока идёт загрузка, к каталогу из окна не обращаются
+    setCursor(loading ? Qt::BusyCursor : Qt::ArrowCursor);
+    m_table->setEnabled(!loading);
+    if (loading)
+    {
+        m_actAdd->setEnabled(false);
+        m_actEdit->setEnabled(false);
+        m_actDelete->setEnabled(false);
     }
-    catch (const ps::PsException& ex)
+    else
     {
-        showError(QString::fromUtf8(ex.what()));
+        setMode(Mode::View);
     }
 }
 
+void ComponentsDialog::selectRow(int row)
+{
+    if (row < 0 || row >= m_model->rowCount()) return;
+
+    m_table->selectRow(row);
+    m_table->scrollTo(m_model->index(row, 0));
+}
+
+int ComponentsDialog::currentRow() const
+{
+    const auto rows = m_table->selectionModel()->selectedRows();
+    return rows.isEmpty() ? -1 : rows.front().row();
+}
+
 void ComponentsDialog::onSelectionChanged()
 {
     if (m_mode != Mode::View) return;
 
-    if (m_table->selectedItems().isEmpty())
+    const int row = currentRow();
+    if (row < 0)
     {
         m_name->clear();
         m_type->setCurrentIndex(2);
@@ -150,13 +215,9 @@ void ComponentsDialog::onSelectionChanged()
         return;
     }
 
-    const auto name = m_table->item(m_table->currentRow(), 0)->text();
-    const auto typeText = m_table->item(m_table->currentRow(), 1)->text();
-
-    m_name->setText(name);
-    if (typeText == QString::fromUtf8("Изделие")) m_type->setCurrentIndex(0);
-    else if (typeText == QString::fromUtf8("Узел")) m_type->setCurrentIndex(1);
-    else m_type->setCurrentIndex(2);
+    const auto rec = m_model->recordAt(row);
+    m_name->setText(QString::fromUtf8(rec.name.c_str()));
+    m_type->setCurrentIndex(typeToIndex(rec.type));
 
     m_actEdit->setEnabled(true);
     m_actDelete->setEnabled(true);
@@ -169,8 +230,10 @@ void ComponentsDialog::onAdd()
 
 void ComponentsDialog::onEdit()
 {
-    if (m_table->selectedItems().isEmpty()) return;
-    m_editOldName = m_table->item(m_table->currentRow(), 0)->text();
+    const int row = currentRow();
+    if (row < 0) return;
+    m_editOldName = QString::fromUtf8(m_model->recordAt(row).name.c_str());
+    m_editRow = row;
     setMode(Mode::Edit);
     m_name->setFocus();
 }
@@ -187,17 +250,20 @@ void ComponentsDialog::onSave()
         const auto nm = m_name->text().trimmed();
         const auto tp = indexToType(m_type->currentIndex());
 
+        // строку в модели меняет событие каталога; здесь она только выбирается
+        ps::RecordId id = ps::NullId;
         if (m_mode == Mode::Add)
         {
-            m_service->InputComponent(ToUtf8Std(nm), tp);
+            id = m_service->InputComponent(ToUtf8Std(nm), tp);
         }
         else if (m_mode == Mode::Edit)
         {
+            id = m_model->recordAt(m_editRow).id;
             m_service->UpdateComponent(ToUtf8Std(m_editOldName), ToUtf8Std(nm), tp);
         }
 
-        reloadTable();
         setMode(Mode::View);
+        selectRow(m_model->rowOf(id));
     }
     catch (const ps::PsException& ex)
     {
@@ -207,8 +273,9 @@ void ComponentsDialog::onSave()
 
 void ComponentsDialog::onDelete()
 {
-    if (m_table->selectedItems().isEmpty()) return;
-    const auto name = m_table->item(m_table->currentRow(), 0)->text();
+    const int row = currentRow();
+    if (row < 0) return;
+    const auto name = QString::fromUtf8(m_model->recordAt(row).name.c_str());
 
     const auto question = QString::fromUtf8("Удалить компонент \"%1\"?").arg(name);
     if (QMessageBox::question(this, QString::fromUtf8("Удалить"), question) != QMessageBox::Yes)
@@ -217,8 +284,8 @@ void ComponentsDialog::onDelete()
     try
     {
         m_service->DeleteComponent(ToUtf8Std(name));
-        reloadTable();
         setMode(Mode::View);
+        selectRow(row < m_model->rowCount() ? row : row - 1);
     }
     catch (const ps::PsException& ex)
     {
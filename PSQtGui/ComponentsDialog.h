@@ -1,10 +1,14 @@
 #pragma once
 #include <QDialog>
+#include <QPointer>
 
-class QTableWidget;
+class CatalogTask;
+class CatalogWorker;
+class QTableView;
 class QLineEdit;
 class QComboBox;
 class QAction;
+class ComponentTableModel;
 
 namespace ps { class CatalogService; }
 
@@ -12,7 +16,8 @@ class ComponentsDialog final : public QDialog
 {
     Q_OBJECT
 public:
-    explicit ComponentsDialog(ps::CatalogService* service, QWidget* parent = nullptr);
+    explicit ComponentsDialog(CatalogWorker* worker, QWidget* parent = nullptr);
+    ~ComponentsDialog() override;
 
 private slots:
     void onAdd();
@@ -27,9 +32,14 @@ private:
 
     void setMode(Mode m);
     void reloadTable();
+    void setLoading(bool loading);
+    void selectRow(int row);
+    int currentRow() const; // -1, если ничего не выбрано
     void showError(const QString& msg);
 
+    CatalogWorker* m_worker = nullptr;
     ps::CatalogService* m_service = nullptr;
+    QPointer<CatalogTask> m_loadTask;
 
     QAction* m_actAdd = nullptr;
     QAction* m_actEdit = nullptr;
@@ -37,10 +47,12 @@ private:
     QAction* m_actSave = nullptr;
     QAction* m_actDelete = nullptr;
 
-    QTableWidget* m_table = nullptr;
+    QTableView* m_table = nullptr;
+    ComponentTableModel* m_model = nullptr;
     QLineEdit* m_name = nullptr;
     QComboBox* m_type = nullptr;
 
     Mode m_mode = Mode::View;
     QString m_editOldName;
+    int m_editRow = -1;
 };
@@ -4,6 +4,10 @@
 #include <QMessageBox>
 #include <QApplication>
 #include <QAction>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QStatusBar>
+#include <QTimer>
 
 #include "services/CatalogService.h"
 #include "core/Errors.h"
@@ -12,6 +16,9 @@
 #include "ComponentsDialog.h"
 #include "SpecificationDialog.h"
 
+// как часто проверять, не изменил ли каталог другой процесс
+static constexpr int ExternalPollMs = 2000;
+
 // Важно: QString::toStdString() использует локальную кодировку (toLocal8Bit),
 // что ломает имена с кириллицей. Всегда передаем в core UTF-8.
 static std::string ToUtf8Std(const QString& s)
@@ -26,6 +33,16 @@ MainWindow::MainWindow()
     resize(720, 480);
 
     m_service = std::make_unique<ps::CatalogService>();
+    m_worker = std::make_unique<CatalogWorker>(m_service.get());
+    // пока операция идёт в фоне, другие операции с каталогом из меню недоступны
+    connect(m_worker.get(), &CatalogWorker::busyChanged, this, [this](bool busy) { menuBar()->setEnabled(!busy); });
+
+    // Каталог на общем диске могут менять и другие копии программы: их изменения
+    // приходят открытым окнам теми же событиями catalogChanged, что и свои.
+    m_service->WatchExternalChanges(true);
+    auto* poll = new QTimer(this);
+    connect(poll, &QTimer::timeout, this, &MainWindow::pollExternalChanges);
+    poll->start(ExternalPollMs);
 
     // Меню как в методичке: Открыть / Компоненты / Спецификация
     auto* mb = menuBar();
@@ -43,37 +60,85 @@ MainWindow::MainWindow()
     auto* aClose = mb->addAction(QString::fromUtf8("Закрыть файлы"));
     connect(aClose, &QAction::triggered, this, &MainWindow::onCloseFiles);
 
+    auto* aTruncate = mb->addAction(QString::fromUtf8("Сжать файлы"));
+    connect(aTruncate, &QAction::triggered, this, &MainWindow::onTruncate);
+
     auto* aAbout = mb->addAction(QString::fromUtf8("О программе"));
     connect(aAbout, &QAction::triggered, this, &MainWindow::onAbout);
 }
 
 MainWindow::~MainWindow() = default;
 
+void MainWindow::runWithProgress(const QString& title, CatalogWorker::Function fn, const QString& doneMessage)
+{
+    QPointer<CatalogTask> task = m_worker->start(std::move(fn));
+    if (task.isNull())
+    {
+        QMessageBox::warning(this, QString::fromUtf8("Внимание"), QString::fromUtf8("Каталог занят другой операцией."));
+        return;
+    }
+
+    // окно появляется, только если операция идёт заметное время
+    auto* progress = new QProgressDialog(title, QString::fromUtf8("Отменить"), 0, 0, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(300);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+
+    connect(progress, &QProgressDialog::canceled, task, &CatalogTask::cancel);
+    connect(task, &CatalogTask::progress, progress, [progress](qint64 done, qint64 total)
+    {
+        // шкала в тысячных: QProgressDialog считает в int
+        progress->setMaximum(total > 0 ? 1000 : 0);
+        progress->setValue(total > 0 ? static_cast<int>(done * 1000 / total) : 0);
+    });
+    connect(task, &CatalogTask::finished, this, [this, progress, doneMessage](const QVariant&)
+    {
+        progress->close();
+        QMessageBox::information(this, QString::fromUtf8("OK"), doneMessage);
+    });
+    connect(task, &CatalogTask::failed, this, [this, progress](const QString& message)
+    {
+        progress->close();
+        QMessageBox::critical(this, QString::fromUtf8("Ошибка"), message);
+    });
+    connect(task, &CatalogTask::cancelled, this, [this, progress]
+    {
+        progress->close();
+        QMessageBox::information(this, QString::fromUtf8("Отменено"), QString::fromUtf8("Операция отменена."));
+    });
+}
+
 void MainWindow::onOpenOrCreate()
 {
     OpenDialog dlg(this);
     if (dlg.exec() != QDialog::Accepted) return;
 
-    try
-    {
-        if (dlg.isCreate())
-            m_service->Create(
-                ToUtf8Std(dlg.baseName()),
-                dlg.maxNameLen(),
-                dlg.prsName().isEmpty() ? std::optional<std::string>{}
-                                        : std::optional<std::string>{ToUtf8Std(dlg.prsName())});
-        else
-            m_service->Open(ToUtf8Std(dlg.baseName()));
-
-        QMessageBox::information(this, QString::fromUtf8("OK"), QString::fromUtf8("Файлы успешно открыты."));
-    }
-    catch (const ps::PsException& ex)
+    // параметры копируются: операция выполняется уже после закрытия диалога
+    const auto baseName = ToUtf8Std(dlg.baseName());
+    if (dlg.isCreate())
     {
-        QMessageBox::critical(this, QString::fromUtf8("Ошибка"), QString::fromUtf8(ex.what()));
+        const auto maxNameLen = static_cast<std::uint16_t>(dlg.maxNameLen());
+        const auto prsName = dlg.prsName().isEmpty() ? std::optional<std::string>{}
+                                                     : std::optional<std::string>{ToUtf8Std(dlg.prsName())};
+        runWithProgress(
+            QString::fromUtf8("Создание файлов..."),
+            [baseName, maxNameLen, prsName](ps::CatalogService& service, CatalogTask&)
+            {
+                service.Create(baseName, maxNameLen, prsName);
+                return QVariant();
+            },
+            QString::fromUtf8("Файлы успешно открыты."));
     }
-    catch (const std::exception& ex)
+    else
     {
-        QMessageBox::critical(this, QString::fromUtf8("Ошибка"), QString::fromUtf8(ex.what()));
+        runWithProgress(
+            QString::fromUtf8("Открытие файлов..."),
+            [baseName](ps::CatalogService& service, CatalogTask&)
+            {
+                service.Open(baseName);
+                return QVariant();
+            },
+            QString::fromUtf8("Файлы успешно открыты."));
     }
 }
 
@@ -88,7 +153,7 @@ void MainWindow::onComponents()
     try
     {
         ensureServiceOpenOrWarn();
-        ComponentsDialog dlg(m_service.get(), this);
+        ComponentsDialog dlg(m_worker.get(), this);
         dlg.exec();
     }
     catch (const ps::PsException& ex)
@@ -102,7 +167,7 @@ void MainWindow::onSpecification()
     try
     {
         ensureServiceOpenOrWarn();
-        SpecificationDialog dlg(m_service.get(), this);
+        SpecificationDialog dlg(m_worker.get(), this);
         dlg.exec();
     }
     catch (const ps::PsException& ex)
@@ -112,15 +177,53 @@ void MainWindow::onSpecification()
 }
 
 void MainWindow::onCloseFiles()
+{
+    // при закрытии сохраняется словарь имён — на большом каталоге это заметно
+    runWithProgress(
+        QString::fromUtf8("Закрытие файлов..."),
+        [](ps::CatalogService& service, CatalogTask&)
+        {
+            service.Close();
+            return QVariant();
+        },
+        QString::fromUtf8("Файлы закрыты."));
+}
+
+void MainWindow::onTruncate()
 {
     try
     {
-        m_service->Close();
-        QMessageBox::information(this, QString::fromUtf8("OK"), QString::fromUtf8("Файлы закрыты."));
+        ensureServiceOpenOrWarn();
     }
-    catch (const std::exception& ex)
+    catch (const ps::PsException& ex)
+    {
+        QMessageBox::warning(this, QString::fromUtf8("Внимание"), QString::fromUtf8(ex.what()));
+        return;
+    }
+
+    runWithProgress(
+        QString::fromUtf8("Сжатие файлов..."),
+        [](ps::CatalogService& service, CatalogTask&)
+        {
+            service.Truncate();
+            return QVariant();
+        },
+        QString::fromUtf8("Удалённые записи убраны из файлов."));
+}
+
+void MainWindow::pollExternalChanges()
+{
+    // пока идёт операция в фоне, каталог из окна недоступен: проверка подождёт следующего раза
+    if (m_worker->isBusy() || !m_service->HasOpenFiles()) return;
+
+    try
+    {
+        m_service->PollExternalChanges();
+    }
+    catch (const ps::PsException& ex)
     {
-        QMessageBox::critical(this, QString::fromUtf8("Ошибка"), QString::fromUtf8(ex.what()));
+        // окно с сообщением выскакивало бы на каждой проверке
+        statusBar()->showMessage(QString::fromUtf8(ex.what()), ExternalPollMs * 2);
     }
 }
 
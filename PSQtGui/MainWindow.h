@@ -1,7 +1,10 @@
 #pragma once
 #include <QMainWindow>
+#include <functional>
 #include <memory>
 
+#include "CatalogWorker.h"
+
 namespace ps { class CatalogService; }
 
 class MainWindow final : public QMainWindow
@@ -16,10 +19,15 @@ private slots:
     void onComponents();
     void onSpecification();
     void onCloseFiles();
+    void onTruncate();
     void onAbout();
+    void pollExternalChanges();
 
 private:
     void ensureServiceOpenOrWarn();
+    // выполнить операцию в потоке каталога с окном хода выполнения и кнопкой отмены
+    void runWithProgress(const QString& title, CatalogWorker::Function fn, const QString& doneMessage);
 
     std::unique_ptr<ps::CatalogService> m_service;
+    std::unique_ptr<CatalogWorker> m_worker; // после m_service: останавливается раньше, чем удаляется каталог
 };
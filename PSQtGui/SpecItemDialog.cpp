@@ -2,8 +2,12 @@
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QDialogButtonBox>
-#include <QComboBox>
+#include <QCompleter>
+#include <QLineEdit>
 #include <QSpinBox>
+#include <QStringListModel>
+
+static constexpr int CompletionLimit = 50; // строк в списке подсказок
 
 SpecItemDialog::SpecItemDialog(QWidget* parent) : QDialog(parent)
 {
@@ -14,8 +18,14 @@ SpecItemDialog::SpecItemDialog(QWidget* parent) : QDialog(parent)
     auto* root = new QVBoxLayout(this);
     auto* form = new QFormLayout();
 
-    m_combo = new QComboBox(this);
-    form->addRow(QString::fromUtf8("Комплектующее:"), m_combo);
+    m_name = new QLineEdit(this);
+    m_completions = new QStringListModel(this);
+    m_completer = new QCompleter(m_completions, this);
+    // варианты уже отобраны каталогом по началу имени: сам completer их не фильтрует
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_name->setCompleter(m_completer);
+    connect(m_name, &QLineEdit::textEdited, this, &SpecItemDialog::updateCompletions);
+    form->addRow(QString::fromUtf8("Комплектующее:"), m_name);
 
     m_qty = new QSpinBox(this);
     m_qty->setRange(1, 65535);
@@ -30,19 +40,19 @@ SpecItemDialog::SpecItemDialog(QWidget* parent) : QDialog(parent)
     root->addWidget(bb);
 }
 
-void SpecItemDialog::setComponents(const QStringList& names)
-{
-    m_combo->clear();
-    m_combo->addItems(names);
-}
+void SpecItemDialog::setCompletionSource(CompletionSource source) { m_source = std::move(source); }
 
-void SpecItemDialog::setSelected(const QString& name)
+void SpecItemDialog::updateCompletions(const QString& text)
 {
-    const int idx = m_combo->findText(name);
-    if (idx >= 0) m_combo->setCurrentIndex(idx);
+    if (!m_source) return;
+
+    m_completions->setStringList(m_source(text, CompletionLimit));
+    m_completer->complete();
 }
 
+void SpecItemDialog::setSelected(const QString& name) { m_name->setText(name); }
+
 void SpecItemDialog::setQty(int qty) { m_qty->setValue(qty); }
 
-QString SpecItemDialog::selectedName() const { return m_combo->currentText(); }
+QString SpecItemDialog::selectedName() const { return m_name->text().trimmed(); }
 int SpecItemDialog::qty() const { return m_qty->value(); }
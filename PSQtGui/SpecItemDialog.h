@@ -1,16 +1,26 @@
 #pragma once
 #include <QDialog>
 
-class QComboBox;
+#include <functional>
+
+class QCompleter;
+class QLineEdit;
 class QSpinBox;
+class QStringListModel;
 
+// Выбор комплектующего и количества. Имя вводится с подсказками: варианты для
+// набранного начала имени даёт источник (setCompletionSource), так что весь
+// список компонентов в диалог не копируется.
 class SpecItemDialog final : public QDialog
 {
     Q_OBJECT
 public:
+    // не больше limit имён, начинающихся с prefix, по алфавиту
+    using CompletionSource = std::function<QStringList(const QString& prefix, int limit)>;
+
     explicit SpecItemDialog(QWidget* parent = nullptr);
 
-    void setComponents(const QStringList& names);
+    void setCompletionSource(CompletionSource source);
     void setSelected(const QString& name);
     void setQty(int qty);
 
@@ -18,6 +28,11 @@ public:
     int qty() const;
 
 private:
-    QComboBox* m_combo = nullptr;
+    void updateCompletions(const QString& text);
+
+    CompletionSource m_source;
+    QLineEdit* m_name = nullptr;
+    QCompleter* m_completer = nullptr;
+    QStringListModel* m_completions = nullptr;
     QSpinBox* m_qty = nullptr;
 };
@@ -0,0 +1,442 @@
+#include "SpecTreeModel.h"
+
+#include <QQueue>
+#include <QSet>
+
+#include <algorithm>
+
+#include "core/Errors.h"
+#include "domain/Collation.h"
+#include "services/CatalogService.h"
+
+static std::string CollationKeyOf(const QString& name)
+{
+    const auto bytes = name.toUtf8();
+    return ps::CollationKey(std::string_view(bytes.constData(), static_cast<std::size_t>(bytes.size())));
+}
+
+SpecTreeModel::SpecTreeModel(ps::CatalogService* service, QObject* parent)
+    : QAbstractItemModel(parent), m_service(service)
+{
+    m_root.fetched = true;
+}
+
+void SpecTreeModel::clear()
+{
+    beginResetModel();
+    m_root.children.clear();
+    endResetModel();
+}
+
+void SpecTreeModel::appendRoots(const std::vector<ps::ComponentRecord>& roots)
+{
+    if (roots.empty()) return;
+
+    const int first = static_cast<int>(m_root.children.size());
+    beginInsertRows({}, first, first + static_cast<int>(roots.size()) - 1);
+    for (const auto& root : roots)
+    {
+        auto node = std::make_unique<Node>();
+        node->id = root.id;
+        node->name = QString::fromUtf8(root.name.c_str());
+        node->type = root.type;
+        node->parent = &m_root;
+        node->row = static_cast<int>(m_root.children.size());
+        m_root.children.push_back(std::move(node));
+    }
+    endInsertRows();
+}
+
+SpecTreeModel::Node* SpecTreeModel::nodeAt(const QModelIndex& index) const
+{
+    if (!index.isValid()) return const_cast<Node*>(&m_root);
+    return static_cast<Node*>(index.internalPointer());
+}
+
+QModelIndex SpecTreeModel::indexOf(const Node* node) const
+{
+    if (node == nullptr || node == &m_root) return {};
+    return createIndex(node->row, 0, const_cast<Node*>(node));
+}
+
+QString SpecTreeModel::nameAt(const QModelIndex& index) const
+{
+    return index.isValid() ? nodeAt(index)->name : QString();
+}
+
+ps::ComponentType SpecTreeModel::typeAt(const QModelIndex& index) const
+{
+    return index.isValid() ? nodeAt(index)->type : ps::ComponentType::Detail;
+}
+
+QModelIndex SpecTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (column != 0 || row < 0) return {};
+
+    const auto* node = nodeAt(parent);
+    if (row >= static_cast<int>(node->children.size())) return {};
+    return createIndex(row, 0, node->children[static_cast<std::size_t>(row)].get());
+}
+
+QModelIndex SpecTreeModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid()) return {};
+    return indexOf(nodeAt(child)->parent);
+}
+
+int SpecTreeModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) return 0;
+    return static_cast<int>(nodeAt(parent)->children.size());
+}
+
+int SpecTreeModel::columnCount(const QModelIndex&) const { return 1; }
+
+QVariant SpecTreeModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return {};
+
+    const auto* node = nodeAt(index);
+    const auto typeName = QString::fromUtf8(ps::ToString(node->type).c_str());
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return node->name;
+    case Qt::ToolTipRole:
+        if (node->parent == &m_root) return typeName;
+        return QString::fromUtf8("qty=%1, тип=%2").arg(node->qty).arg(typeName);
+    default:
+        return {};
+    }
+}
+
+bool SpecTreeModel::hasChildren(const QModelIndex& parent) const
+{
+    const auto* node = nodeAt(parent);
+    if (node == &m_root) return !node->children.empty();
+
+    // до раскрытия состав неизвестен: у узла и изделия показывается стрелка
+    if (node->type == ps::ComponentType::Detail) return false;
+    return !node->fetched || !node->children.empty();
+}
+
+bool SpecTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    const auto* node = nodeAt(parent);
+    return node->type != ps::ComponentType::Detail && !node->fetched;
+}
+
+void SpecTreeModel::fetchMore(const QModelIndex& parent)
+{
+    fetch(nodeAt(parent));
+}
+
+bool SpecTreeModel::fetch(Node* node)
+{
+    if (node->fetched || node->type == ps::ComponentType::Detail) return true;
+    node->fetched = true; // и при ошибке: повторный запрос дал бы ту же ошибку
+
+    std::vector<ps::SpecItemView> items;
+    try
+    {
+        items = m_service->ListSpecItems(node->id);
+    }
+    catch (const ps::PsException& ex)
+    {
+        emit loadFailed(QString::fromUtf8(ex.what()));
+        return false;
+    }
+
+    if (items.empty())
+    {
+        // стрелка у пустого узла больше не нужна
+        const auto index = indexOf(node);
+        emit dataChanged(index, index);
+        return true;
+    }
+
+    beginInsertRows(indexOf(node), 0, static_cast<int>(items.size()) - 1);
+    for (const auto& item : items)
+    {
+        auto child = std::make_unique<Node>();
+        child->id = item.partId;
+        child->specId = item.specId;
+        child->name = QString::fromUtf8(item.partName.c_str());
+        child->type = item.type;
+        child->qty = item.qty;
+        child->parent = node;
+        child->row = static_cast<int>(node->children.size());
+        node->children.push_back(std::move(child));
+    }
+    endInsertRows();
+    return true;
+}
+
+QModelIndex SpecTreeModel::locate(const QString& name)
+{
+    QSet<ps::RecordId> expanded;
+    QQueue<Node*> queue;
+    for (const auto& root : m_root.children) queue.enqueue(root.get());
+
+    while (!queue.isEmpty())
+    {
+        auto* node = queue.dequeue();
+        if (node->name == name) return indexOf(node);
+
+        if (node->type == ps::ComponentType::Detail || expanded.contains(node->id)) continue;
+        expanded.insert(node->id);
+
+        if (!fetch(node)) return {};
+        for (const auto& child : node->children) queue.enqueue(child.get());
+    }
+    return {};
+}
+
+std::vector<SpecTreeModel::Node*> SpecTreeModel::fetchedNodesOf(ps::RecordId id)
+{
+    std::vector<Node*> out;
+    for (const auto& root : m_root.children) collect(root.get(), id, out);
+    return out;
+}
+
+void SpecTreeModel::collect(Node* node, ps::RecordId id, std::vector<Node*>& out)
+{
+    if (node->id == id && node->fetched) out.push_back(node);
+    for (const auto& child : node->children) collect(child.get(), id, out);
+}
+
+void SpecTreeModel::insertChild(Node* parent, int pos, std::unique_ptr<Node> child)
+{
+    beginInsertRows(indexOf(parent), pos, pos);
+    child->parent = parent;
+    parent->children.insert(parent->children.begin() + pos, std::move(child));
+    for (std::size_t i = static_cast<std::size_t>(pos); i < parent->children.size(); i++)
+        parent->children[i]->row = static_cast<int>(i);
+    endInsertRows();
+}
+
+void SpecTreeModel::removeChild(Node* parent, int pos)
+{
+    beginRemoveRows(indexOf(parent), pos, pos);
+    parent->children.erase(parent->children.begin() + pos);
+    for (std::size_t i = static_cast<std::size_t>(pos); i < parent->children.size(); i++)
+        parent->children[i]->row = static_cast<int>(i);
+    endRemoveRows();
+}
+
+void SpecTreeModel::resetChildren(Node* node)
+{
+    // состав будет прочитан заново при раскрытии
+    if (!node->children.empty())
+    {
+        beginRemoveRows(indexOf(node), 0, static_cast<int>(node->children.size()) - 1);
+        node->children.clear();
+        endRemoveRows();
+    }
+    node->fetched = node->type == ps::ComponentType::Detail;
+}
+
+int SpecTreeModel::childWithSpec(const Node* parent, ps::RecordId specId)
+{
+    for (std::size_t i = 0; i < parent->children.size(); i++)
+        if (parent->children[i]->specId == specId) return static_cast<int>(i);
+    return -1;
+}
+
+int SpecTreeModel::rootPosition(const QString& name, int skipRow) const
+{
+    const auto key = CollationKeyOf(name);
+    auto realRow = [&](int v) { return skipRow >= 0 && v >= skipRow ? v + 1 : v; };
+
+    int lo = 0;
+    int hi = static_cast<int>(m_root.children.size()) - (skipRow >= 0 ? 1 : 0);
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (CollationKeyOf(m_root.children[static_cast<std::size_t>(realRow(mid))]->name) < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void SpecTreeModel::updateRoot(ps::RecordId id)
+{
+    int row = -1;
+    for (std::size_t i = 0; i < m_root.children.size() && row < 0; i++)
+        if (m_root.children[i]->id == id) row = static_cast<int>(i);
+
+    const bool isRoot = m_service->IsSpecificationRoot(id);
+    if (!isRoot)
+    {
+        if (row >= 0) removeChild(&m_root, row);
+        return;
+    }
+
+    if (row < 0)
+    {
+        const auto rec = m_service->ReadComponent(id);
+        auto node = std::make_unique<Node>();
+        node->id = rec.id;
+        node->name = QString::fromUtf8(rec.name.c_str());
+        node->type = rec.type;
+
+        const int pos = rootPosition(node->name, -1);
+        insertChild(&m_root, pos, std::move(node));
+        return;
+    }
+
+    // имя могло измениться: корень переезжает вместе с загруженным составом
+    const int target = rootPosition(m_root.children[static_cast<std::size_t>(row)]->name, row);
+    if (target == row) return;
+
+    beginMoveRows({}, row, row, {}, target > row ? target + 1 : target);
+    auto node = std::move(m_root.children[static_cast<std::size_t>(row)]);
+    m_root.children.erase(m_root.children.begin() + row);
+    m_root.children.insert(m_root.children.begin() + target, std::move(node));
+    for (std::size_t i = 0; i < m_root.children.size(); i++) m_root.children[i]->row = static_cast<int>(i);
+    endMoveRows();
+}
+
+void SpecTreeModel::applyEvent(const ps::CatalogEvent& event)
+{
+    using Kind = ps::CatalogEvent::Kind;
+
+    try
+    {
+        switch (event.kind)
+        {
+        case Kind::LinkAdded:
+            linkAdded(event);
+            break;
+        case Kind::LinkUpdated:
+            linkUpdated(event);
+            break;
+        case Kind::LinkRemoved:
+            linkRemoved(event);
+            break;
+        case Kind::ComponentAdded:
+            // новый компонент ни во что не входит: изделие или узел становятся корнем
+            updateRoot(event.componentId);
+            break;
+        case Kind::ComponentChanged:
+            componentChanged(event.componentId);
+            break;
+        default:
+            emit reloadNeeded();
+            break;
+        }
+    }
+    catch (const ps::PsException& ex)
+    {
+        emit loadFailed(QString::fromUtf8(ex.what()));
+    }
+}
+
+void SpecTreeModel::linkAdded(const ps::CatalogEvent& event)
+{
+    const auto owners = fetchedNodesOf(event.ownerId);
+    if (!owners.empty())
+    {
+        // позиция связи в цепочке: восстановленная связь остаётся на своём месте
+        const auto items = m_service->ListSpecItems(event.ownerId);
+        int pos = -1;
+        for (std::size_t i = 0; i < items.size() && pos < 0; i++)
+            if (items[i].specId == event.specId) pos = static_cast<int>(i);
+
+        if (pos >= 0)
+        {
+            const auto& item = items[static_cast<std::size_t>(pos)];
+            for (auto* owner : owners)
+            {
+                auto child = std::make_unique<Node>();
+                child->id = item.partId;
+                child->specId = item.specId;
+                child->name = QString::fromUtf8(item.partName.c_str());
+                child->type = item.type;
+                child->qty = item.qty;
+                child->fetched = item.type == ps::ComponentType::Detail;
+                insertChild(owner, std::min(pos, static_cast<int>(owner->children.size())), std::move(child));
+            }
+        }
+    }
+
+    updateRoot(event.componentId);
+}
+
+void SpecTreeModel::linkUpdated(const ps::CatalogEvent& event)
+{
+    const auto owners = fetchedNodesOf(event.ownerId);
+    if (!owners.empty())
+    {
+        const auto part = m_service->ReadComponent(event.componentId);
+        for (auto* owner : owners)
+        {
+            const int pos = childWithSpec(owner, event.specId);
+            if (pos < 0) continue;
+
+            auto* child = owner->children[static_cast<std::size_t>(pos)].get();
+            if (child->id != part.id)
+            {
+                resetChildren(child);
+                child->id = part.id;
+                child->name = QString::fromUtf8(part.name.c_str());
+                child->type = part.type;
+                child->fetched = part.type == ps::ComponentType::Detail;
+            }
+            child->qty = event.qty;
+
+            const auto index = indexOf(child);
+            emit dataChanged(index, index);
+        }
+    }
+
+    if (event.previousComponentId != event.componentId)
+    {
+        updateRoot(event.previousComponentId);
+        updateRoot(event.componentId);
+    }
+}
+
+void SpecTreeModel::linkRemoved(const ps::CatalogEvent& event)
+{
+    for (auto* owner : fetchedNodesOf(event.ownerId))
+    {
+        const int pos = childWithSpec(owner, event.specId);
+        if (pos >= 0) removeChild(owner, pos);
+    }
+
+    // комплектующее, на которое больше никто не ссылается, становится корнем
+    updateRoot(event.componentId);
+}
+
+void SpecTreeModel::componentChanged(ps::RecordId id)
+{
+    const auto rec = m_service->ReadComponent(id);
+    const auto name = QString::fromUtf8(rec.name.c_str());
+
+    // все загруженные вхождения, в том числе нераскрытые
+    std::vector<Node*> pending{ &m_root };
+    while (!pending.empty())
+    {
+        auto* node = pending.back();
+        pending.pop_back();
+        for (const auto& child : node->children)
+        {
+            pending.push_back(child.get());
+            if (child->id != id) continue;
+
+            if (child->type != rec.type)
+            {
+                child->type = rec.type;
+                resetChildren(child.get());
+            }
+            child->name = name;
+
+            const auto index = indexOf(child.get());
+            emit dataChanged(index, index);
+        }
+    }
+
+    updateRoot(id);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <QAbstractItemModel>
+
+#include <memory>
+#include <vector>
+
+#include "domain/Models.h"
+#include "services/CatalogEvents.h"
+
+namespace ps { class CatalogService; }
+
+// Дерево спецификаций с подгрузкой по раскрытию: корни модель получает готовыми
+// (appendRoots), состав узла запрашивается у каталога по номеру записи при первом
+// раскрытии (canFetchMore/fetchMore) и остаётся в модели до следующего clear.
+// События каталога (applyEvent) правят загруженные уровни на месте.
+class SpecTreeModel final : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    explicit SpecTreeModel(ps::CatalogService* service, QObject* parent = nullptr);
+
+    // убрать всё дерево вместе с загруженными уровнями
+    void clear();
+    // дописать корни в конец (порциями, по мере того как каталог их находит)
+    void appendRoots(const std::vector<ps::ComponentRecord>& roots);
+
+    QString nameAt(const QModelIndex& index) const;
+    ps::ComponentType typeAt(const QModelIndex& index) const;
+
+    // Ближайший к корням элемент с таким именем (невалидный индекс, если его нет).
+    // Незагруженные уровни подгружаются по ходу обхода в ширину; состав одного
+    // компонента раскрывается один раз, сколько бы раз он ни входил в дерево.
+    QModelIndex locate(const QString& name);
+
+    // Связи и новые/переименованные компоненты меняют дерево точечно: каждое
+    // загруженное вхождение владельца получает изменение, корни добавляются и
+    // убираются по одному. Удаление и восстановление компонентов, а также
+    // Reloaded меняют корни непредсказуемо — модель просит построить дерево заново.
+    void applyEvent(const ps::CatalogEvent& event);
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = {}) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    bool hasChildren(const QModelIndex& parent = {}) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+signals:
+    void loadFailed(const QString& message);
+    void reloadNeeded();
+
+private:
+    struct Node
+    {
+        ps::RecordId id = ps::NullId;
+        ps::RecordId specId = ps::NullId; // запись .prs связи с родителем; у корня — NullId
+        QString name;
+        ps::ComponentType type = ps::ComponentType::Detail;
+        int qty = 0; // 0 — корень
+        Node* parent = nullptr;
+        int row = 0;
+        bool fetched = false;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    ps::CatalogService* m_service = nullptr;
+    Node m_root; // невидимый корень; его дети — корни спецификаций
+
+    Node* nodeAt(const QModelIndex& index) const;
+    QModelIndex indexOf(const Node* node) const;
+    bool fetch(Node* node);
+
+    // загруженные вхождения компонента, состав которых уже прочитан
+    std::vector<Node*> fetchedNodesOf(ps::RecordId id);
+    void collect(Node* node, ps::RecordId id, std::vector<Node*>& out);
+    void insertChild(Node* parent, int pos, std::unique_ptr<Node> child);
+    void removeChild(Node* parent, int pos);
+    void resetChildren(Node* node);
+    static int childWithSpec(const Node* parent, ps::RecordId specId);
+
+    // строка, на которую встаёт корень с именем name по алфавиту (skipRow не учитывается)
+    int rootPosition(const QString& name, int skipRow) const;
+    // привести вхождение компонента в корни в соответствие с каталогом
+    void updateRoot(ps::RecordId id);
+
+    void linkAdded(const ps::CatalogEvent& event);
+    void linkUpdated(const ps::CatalogEvent& event);
+    void linkRemoved(const ps::CatalogEvent& event);
+    void componentChanged(ps::RecordId id);
+};
@@ -1,5 +1,7 @@
 #include "SpecificationDialog.h"
+#include "CatalogWorker.h"
 #include "SpecItemDialog.h"
+#include "SpecTreeModel.h"
 
 #include <QAction>
 #include <QComboBox>
@@ -7,17 +9,16 @@
 #include <QLineEdit>
 #include <QMenu>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QPushButton>
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
+#include <QTreeView>
 #include <QVBoxLayout>
 
 #include "core/Errors.h"
 #include "domain/Models.h"
 #include "services/CatalogService.h"
 
-static constexpr int ROLE_NAME = Qt::UserRole + 1;
-static constexpr int ROLE_TYPE = Qt::UserRole + 2;
+static constexpr std::size_t RootBatch = 256; // корней за одну порцию в дерево
 
 static std::string ToUtf8Std(const QString& s)
 {
@@ -25,8 +26,8 @@ static std::string ToUtf8Std(const QString& s)
     return std::string(bytes.constData(), static_cast<std::size_t>(bytes.size()));
 }
 
-SpecificationDialog::SpecificationDialog(ps::CatalogService* service, QWidget* parent)
-    : QDialog(parent), m_service(service)
+SpecificationDialog::SpecificationDialog(CatalogWorker* worker, QWidget* parent)
+    : QDialog(parent), m_worker(worker), m_service(worker->service())
 {
     setWindowTitle(QString::fromUtf8("Спецификация"));
     resize(640, 420);
@@ -53,40 +54,51 @@ SpecificationDialog::SpecificationDialog(ps::CatalogService* service, QWidget* p
     connect(m_refresh, &QPushButton::clicked, this, &SpecificationDialog::rebuildTree);
     root->addLayout(ownerRow);
 
-    m_tree = new QTreeWidget(this);
+    // состав узлов читается при раскрытии, а не при открытии диалога
+    m_model = new SpecTreeModel(m_service, this);
+    connect(m_model, &SpecTreeModel::loadFailed, this, &SpecificationDialog::showError);
+    // правки спецификаций попадают в дерево событиями каталога, без перестроения
+    connect(m_worker, &CatalogWorker::catalogChanged, m_model, &SpecTreeModel::applyEvent);
+    connect(m_model, &SpecTreeModel::reloadNeeded, this, &SpecificationDialog::rebuildTree);
+
+    m_tree = new QTreeView(this);
+    m_tree->setModel(m_model);
     m_tree->setHeaderHidden(true);
+    m_tree->setUniformRowHeights(true);
     m_tree->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(m_tree, &QTreeWidget::customContextMenuRequested, this, &SpecificationDialog::onContextMenuRequested);
+    connect(m_tree, &QTreeView::customContextMenuRequested, this, &SpecificationDialog::onContextMenuRequested);
     root->addWidget(m_tree, 1);
 
+    auto* progressRow = new QHBoxLayout();
+    m_progress = new QProgressBar(this);
+    m_progress->setRange(0, 1000);
+    m_progress->setTextVisible(false);
+    m_stop = new QPushButton(QString::fromUtf8("Остановить"), this);
+    progressRow->addWidget(m_progress, 1);
+    progressRow->addWidget(m_stop);
+    root->addLayout(progressRow);
+
     rebuildTree();
 }
 
+SpecificationDialog::~SpecificationDialog()
+{
+    // построение дерева не должно пережить диалог
+    if (!m_loadTask.isNull()) m_worker->cancelAndWait();
+}
+
 void SpecificationDialog::showError(const QString& msg)
 {
     QMessageBox::critical(this, QString::fromUtf8("Ошибка"), msg);
 }
 
-void SpecificationDialog::reloadOwners(const QString& preferredOwner)
+void SpecificationDialog::fillOwners(const QStringList& owners)
 {
-    QString ownerToKeep = preferredOwner;
-    if (ownerToKeep.isEmpty()) ownerToKeep = m_owner->currentText();
+    // выбор, сделанный до конца загрузки, сохраняется
+    const auto ownerToKeep = m_owner->currentText();
 
     m_owner->clear();
-
-    try
-    {
-        for (const auto& component : m_service->ListComponents())
-        {
-            if (component.type == ps::ComponentType::Detail) continue;
-            m_owner->addItem(QString::fromUtf8(component.name.c_str()));
-        }
-    }
-    catch (const ps::PsException& ex)
-    {
-        showError(QString::fromUtf8(ex.what()));
-    }
-
+    m_owner->addItems(owners);
     selectOwner(ownerToKeep);
 }
 
@@ -96,66 +108,96 @@ void SpecificationDialog::selectOwner(const QString& ownerName)
     if (index >= 0) m_owner->setCurrentIndex(index);
 }
 
-QStringList SpecificationDialog::componentChoices(const QString& ownerName) const
+SpecItemDialog::CompletionSource SpecificationDialog::componentSource(const QString& ownerName) const
 {
-    QStringList choices;
-    for (const auto& component : m_service->ListComponents())
+    return [service = m_service, ownerName](const QString& prefix, int limit)
     {
-        const auto componentName = QString::fromUtf8(component.name.c_str());
-        if (componentName == ownerName) continue;
-        choices << componentName;
-    }
-    return choices;
+        QStringList names;
+        try
+        {
+            // владелец может оказаться среди найденных: имён запрашивается на одно больше
+            for (const auto& component : service->ListComponentsByPrefix(ToUtf8Std(prefix), static_cast<std::size_t>(limit) + 1))
+            {
+                const auto name = QString::fromUtf8(component.name.c_str());
+                if (name != ownerName && names.size() < limit) names << name;
+            }
+        }
+        catch (const ps::PsException&)
+        {
+            // без подсказок; ошибку покажет само изменение спецификации
+        }
+        return names;
+    };
 }
 
 void SpecificationDialog::rebuildTree()
 {
-    const auto selectedOwner = m_owner->currentText();
-
-    m_tree->clear();
-    reloadOwners(selectedOwner);
+    m_ctxIndex = {};
+    m_model->clear();
 
-    try
+    // Корни ищутся в потоке каталога и появляются в дереве порциями; затем
+    // там же собирается список владельцев для выбора.
+    m_loadTask = m_worker->start([](ps::CatalogService& service, CatalogTask& task)
     {
-        for (const auto& root : m_service->ListSpecificationRoots())
+        std::vector<ps::ComponentRecord> batch;
+        service.ListSpecificationRoots([&](const ps::ComponentRecord& root)
         {
-            auto* rootItem = new QTreeWidgetItem(m_tree);
-            rootItem->setText(0, QString::fromUtf8(root.name.c_str()));
-            rootItem->setData(0, ROLE_NAME, QString::fromUtf8(root.name.c_str()));
-            rootItem->setData(0, ROLE_TYPE, static_cast<int>(root.type));
-            rootItem->setToolTip(0, QString::fromUtf8(ps::ToString(root.type).c_str()));
-
-            addChildrenRec(rootItem, QString::fromUtf8(root.name.c_str()), 0);
-        }
-
-        m_tree->expandAll();
-    }
-    catch (const ps::PsException& ex)
+            batch.push_back(root);
+            if (batch.size() < RootBatch) return;
+
+            task.publish(QVariant::fromValue(batch));
+            batch.clear();
+        });
+        task.publish(QVariant::fromValue(batch));
+
+        QStringList owners;
+        for (const auto& component : service.ListComponents())
+            if (component.type != ps::ComponentType::Detail) owners << QString::fromUtf8(component.name.c_str());
+        return QVariant(owners);
+    });
+    if (m_loadTask.isNull())
     {
-        showError(QString::fromUtf8(ex.what()));
+        showError(QString::fromUtf8("Каталог занят другой операцией."));
+        return;
     }
+
+    setLoading(true);
+    connect(m_stop, &QPushButton::clicked, m_loadTask, &CatalogTask::cancel);
+    connect(m_loadTask, &CatalogTask::progress, m_progress, [this](qint64 done, qint64 total)
+    {
+        m_progress->setValue(total > 0 ? static_cast<int>(done * 1000 / total) : 0);
+    });
+    connect(m_loadTask, &CatalogTask::partial, m_model, [this](const QVariant& roots)
+    {
+        m_model->appendRoots(roots.value<std::vector<ps::ComponentRecord>>());
+    });
+    connect(m_loadTask, &CatalogTask::finished, this, [this](const QVariant& owners)
+    {
+        fillOwners(owners.toStringList());
+        setLoading(false);
+    });
+    connect(m_loadTask, &CatalogTask::failed, this, [this](const QString& message)
+    {
+        setLoading(false);
+        showError(message);
+    });
+    // остановленное дерево остаётся неполным до следующего "Обновить"
+    connect(m_loadTask, &CatalogTask::cancelled, this, [this] { setLoading(false); });
 }
 
-void SpecificationDialog::addChildrenRec(QTreeWidgetItem* parentItem, const QString& ownerName, int depth)
+void SpecificationDialog::setLoading(bool loading)
 {
-    if (depth > 50) return;
-
-    const auto items = m_service->ListSpecItems(ToUtf8Std(ownerName));
-    for (const auto& item : items)
-    {
-        auto* child = new QTreeWidgetItem(parentItem);
-        child->setText(0, QString::fromUtf8(item.partName.c_str()));
-        child->setData(0, ROLE_NAME, QString::fromUtf8(item.partName.c_str()));
-        child->setData(0, ROLE_TYPE, static_cast<int>(item.type));
-        child->setToolTip(
-            0,
-            QString::fromUtf8("qty=%1, тип=%2")
-                .arg(item.qty)
-                .arg(QString::fromUtf8(ps::ToString(item.type).c_str())));
-
-        if (item.type != ps::ComponentType::Detail)
-            addChildrenRec(child, QString::fromUtf8(item.partName.c_str()), depth + 1);
-    }
+    // Пока идёт загрузка, к каталогу из окна не обращаются: уже найденные корни
+    // видны, но не раскрываются, правка и поиск недоступны.
+    m_tree->setItemsExpandable(!loading);
+    m_find->setEnabled(!loading);
+    m_owner->setEnabled(!loading);
+    m_addLink->setEnabled(!loading);
+    m_refresh->setEnabled(!loading);
+
+    m_progress->setValue(0);
+    m_progress->setVisible(loading);
+    m_stop->setVisible(loading);
 }
 
 void SpecificationDialog::onFind()
@@ -163,23 +205,29 @@ void SpecificationDialog::onFind()
     const auto target = m_search->text().trimmed();
     if (target.isEmpty()) return;
 
-    QList<QTreeWidgetItem*> stack;
-    for (int i = 0; i < m_tree->topLevelItemCount(); i++)
-        stack.push_back(m_tree->topLevelItem(i));
+    // кандидаты — из индекса имён каталога (часть имени или имя с опечаткой),
+    // в дереве выбирается первый из них, который в нём есть; нераскрытые
+    // уровни модель подгружает сама
+    std::vector<ps::ComponentRecord> found;
+    try
+    {
+        found = m_service->FindComponents(ToUtf8Std(target));
+    }
+    catch (const ps::PsException& ex)
+    {
+        showError(QString::fromUtf8(ex.what()));
+        return;
+    }
 
-    while (!stack.isEmpty())
+    for (const auto& component : found)
     {
-        auto* item = stack.takeLast();
-        if (item->text(0).compare(target, Qt::CaseInsensitive) == 0)
-        {
-            m_tree->setCurrentItem(item);
-            m_tree->scrollToItem(item);
-            selectOwner(item->data(0, ROLE_NAME).toString());
-            return;
-        }
+        const auto index = m_model->locate(QString::fromUtf8(component.name.c_str()));
+        if (!index.isValid()) continue;
 
-        for (int i = 0; i < item->childCount(); i++)
-            stack.push_back(item->child(i));
+        m_tree->setCurrentIndex(index);
+        m_tree->scrollTo(index);
+        selectOwner(m_model->nameAt(index));
+        return;
     }
 
     QMessageBox::information(this, QString::fromUtf8("Найти"), QString::fromUtf8("Элемент не найден."));
@@ -189,15 +237,15 @@ void SpecificationDialog::openAddDialogForOwner(const QString& ownerName)
 {
     if (ownerName.isEmpty()) return;
 
-    const auto choices = componentChoices(ownerName);
-    if (choices.isEmpty())
+    const auto source = componentSource(ownerName);
+    if (source(QString(), 1).isEmpty())
     {
         QMessageBox::information(this, QString::fromUtf8("Спецификация"), QString::fromUtf8("Нет доступных компонентов для добавления связи."));
         return;
     }
 
     SpecItemDialog dlg(this);
-    dlg.setComponents(choices);
+    dlg.setCompletionSource(source);
     if (dlg.exec() != QDialog::Accepted) return;
 
     m_service->InputSpecItem(
@@ -205,7 +253,6 @@ void SpecificationDialog::openAddDialogForOwner(const QString& ownerName)
         ToUtf8Std(dlg.selectedName()),
         static_cast<std::uint16_t>(dlg.qty()));
 
-    rebuildTree();
     selectOwner(ownerName);
 }
 
@@ -223,8 +270,10 @@ void SpecificationDialog::onAddFromOwner()
 
 void SpecificationDialog::onContextMenuRequested(const QPoint& pos)
 {
-    m_ctxItem = m_tree->itemAt(pos);
-    if (!m_ctxItem) return;
+    if (m_worker->isBusy()) return;
+
+    m_ctxIndex = m_tree->indexAt(pos);
+    if (!m_ctxIndex.isValid()) return;
 
     QMenu menu(this);
     auto* addAction = menu.addAction(QString::fromUtf8("Добавить"));
@@ -235,10 +284,9 @@ void SpecificationDialog::onContextMenuRequested(const QPoint& pos)
     connect(editAction, &QAction::triggered, this, &SpecificationDialog::onEdit);
     connect(deleteAction, &QAction::triggered, this, &SpecificationDialog::onDelete);
 
-    const auto type = static_cast<ps::ComponentType>(m_ctxItem->data(0, ROLE_TYPE).toInt());
-    if (type == ps::ComponentType::Detail) addAction->setEnabled(false);
+    if (m_model->typeAt(m_ctxIndex) == ps::ComponentType::Detail) addAction->setEnabled(false);
 
-    if (!m_ctxItem->parent())
+    if (!m_ctxIndex.parent().isValid())
     {
         editAction->setEnabled(false);
         deleteAction->setEnabled(false);
@@ -249,11 +297,10 @@ void SpecificationDialog::onContextMenuRequested(const QPoint& pos)
 
 void SpecificationDialog::onAdd()
 {
-    if (!m_ctxItem) return;
+    if (!m_ctxIndex.isValid()) return;
 
-    const auto ownerName = m_ctxItem->data(0, ROLE_NAME).toString();
-    const auto ownerType = static_cast<ps::ComponentType>(m_ctxItem->data(0, ROLE_TYPE).toInt());
-    if (ownerType == ps::ComponentType::Detail) return;
+    const auto ownerName = m_model->nameAt(m_ctxIndex);
+    if (m_model->typeAt(m_ctxIndex) == ps::ComponentType::Detail) return;
 
     try
     {
@@ -267,10 +314,10 @@ void SpecificationDialog::onAdd()
 
 void SpecificationDialog::onEdit()
 {
-    if (!m_ctxItem || !m_ctxItem->parent()) return;
+    if (!m_ctxIndex.isValid() || !m_ctxIndex.parent().isValid()) return;
 
-    const auto parentName = m_ctxItem->parent()->data(0, ROLE_NAME).toString();
-    const auto oldPartName = m_ctxItem->data(0, ROLE_NAME).toString();
+    const auto parentName = m_model->nameAt(m_ctxIndex.parent());
+    const auto oldPartName = m_model->nameAt(m_ctxIndex);
 
     try
     {
@@ -285,7 +332,7 @@ void SpecificationDialog::onEdit()
         }
 
         SpecItemDialog dlg(this);
-        dlg.setComponents(componentChoices(parentName));
+        dlg.setCompletionSource(componentSource(parentName));
         dlg.setSelected(oldPartName);
         dlg.setQty(oldQty);
 
@@ -297,7 +344,6 @@ void SpecificationDialog::onEdit()
             ToUtf8Std(dlg.selectedName()),
             static_cast<std::uint16_t>(dlg.qty()));
 
-        rebuildTree();
         selectOwner(parentName);
     }
     catch (const ps::PsException& ex)
@@ -308,10 +354,10 @@ void SpecificationDialog::onEdit()
 
 void SpecificationDialog::onDelete()
 {
-    if (!m_ctxItem || !m_ctxItem->parent()) return;
+    if (!m_ctxIndex.isValid() || !m_ctxIndex.parent().isValid()) return;
 
-    const auto parentName = m_ctxItem->parent()->data(0, ROLE_NAME).toString();
-    const auto partName = m_ctxItem->data(0, ROLE_NAME).toString();
+    const auto parentName = m_model->nameAt(m_ctxIndex.parent());
+    const auto partName = m_model->nameAt(m_ctxIndex);
 
     const auto question = QString::fromUtf8("Удалить \"%1\" из спецификации \"%2\"?")
         .arg(partName)
@@ -322,7 +368,6 @@ void SpecificationDialog::onDelete()
     try
     {
         m_service->DeleteSpecItem(ToUtf8Std(parentName), ToUtf8Std(partName));
-        rebuildTree();
         selectOwner(parentName);
     }
     catch (const ps::PsException& ex)
@@ -1,11 +1,18 @@
 #pragma once
 #include <QDialog>
+#include <QPersistentModelIndex>
+#include <QPointer>
 
+#include "SpecItemDialog.h"
+
+class CatalogTask;
+class CatalogWorker;
 class QComboBox;
 class QLineEdit;
+class QProgressBar;
 class QPushButton;
-class QTreeWidget;
-class QTreeWidgetItem;
+class QTreeView;
+class SpecTreeModel;
 
 namespace ps { class CatalogService; }
 
@@ -13,7 +20,8 @@ class SpecificationDialog final : public QDialog
 {
     Q_OBJECT
 public:
-    explicit SpecificationDialog(ps::CatalogService* service, QWidget* parent = nullptr);
+    explicit SpecificationDialog(CatalogWorker* worker, QWidget* parent = nullptr);
+    ~SpecificationDialog() override;
 
 private slots:
     void onFind();
@@ -25,21 +33,27 @@ private slots:
 
 private:
     void rebuildTree();
-    void reloadOwners(const QString& preferredOwner = {});
+    void setLoading(bool loading);
+    void fillOwners(const QStringList& owners);
     void selectOwner(const QString& ownerName);
-    QStringList componentChoices(const QString& ownerName) const;
+    // подсказки при выборе комплектующего для ownerName (без него самого)
+    SpecItemDialog::CompletionSource componentSource(const QString& ownerName) const;
     void openAddDialogForOwner(const QString& ownerName);
-    void addChildrenRec(QTreeWidgetItem* parentItem, const QString& ownerName, int depth);
     void showError(const QString& msg);
 
+    CatalogWorker* m_worker = nullptr;
     ps::CatalogService* m_service = nullptr;
+    QPointer<CatalogTask> m_loadTask;
 
     QLineEdit* m_search = nullptr;
     QPushButton* m_find = nullptr;
     QComboBox* m_owner = nullptr;
     QPushButton* m_addLink = nullptr;
     QPushButton* m_refresh = nullptr;
-    QTreeWidget* m_tree = nullptr;
+    QPushButton* m_stop = nullptr;
+    QProgressBar* m_progress = nullptr;
+    QTreeView* m_tree = nullptr;
+    SpecTreeModel* m_model = nullptr;
 
-    QTreeWidgetItem* m_ctxItem = nullptr;
+    QPersistentModelIndex m_ctxIndex;
 };
@@ -1,10 +1,22 @@
 #include <QApplication>
 #include "MainWindow.h"
 
+#include "core/Errors.h"
+#include "core/Profiling.h"
+
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    try
+    {
+        ps::StartProfilingFromEnvironment();
+    }
+    catch (const ps::PsException& ex)
+    {
+        qWarning("PS_PROFILE: %s", ex.what());
+    }
+
     MainWindow w;
     w.show();
 